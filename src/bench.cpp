@@ -0,0 +1,85 @@
+#include "engine/board.h"
+#include "engine/attacks.h"
+#include "engine/ai.h"
+#include "engine/tt.h"
+#include "engine/pawns.h"
+#include "engine/evaluation.h"
+#include "engine/nnue.h"
+#include "engine/utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+// Fixed position set for comparing search changes at equal depth
+static const char* benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r2q1rk1/pp2bppp/2n1pn2/3p4/3P4/2NBPN2/PP3PPP/R2Q1RK1 b - - 0 10",
+};
+
+int main(int argc, char* argv[]) {
+    // Usage: chess_bench [depth] [threads] [network file [scalar|sse4|avx2]]
+    // Without a network file the classical evaluation is used
+    int depth = argc > 1 ? std::atoi(argv[1]) : 6;
+    searchThreads = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1;
+
+    initializeAttackTables();
+    initializeZobrist();
+    transpositionTable.resize(DEFAULT_HASH_MB);
+    if (argc > 3) {
+        if (!loadNetwork(argv[3])) return 1;
+        std::string simd = argc > 4 ? argv[4] : "";
+        if (!simd.empty() && !setNnueSimd(simd == "avx2" ? NNUE_AVX2 : simd == "sse4" ? NNUE_SSE4 : NNUE_SCALAR)) {
+            std::cout << "NNUE: " << simd << " is not supported on this CPU\n";
+            return 1;
+        }
+        setEvalBackend(EVAL_NNUE);
+    }
+    printSearchInfo = false;
+
+    uint64_t totalNodes = 0;
+    uint64_t pawnProbes = 0, pawnHits = 0;
+    double logEbfSum = 0;
+    int positions = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const char* fen : benchPositions) {
+        Position pos;
+        setPositionFromFen(pos, fen);
+        transpositionTable.clear(); // Every position starts from empty tables, so runs are repeatable
+        clearPawnTable();
+
+        SearchLimits limits;
+        limits.depth = depth;
+        SearchResult result = findBestMove(pos, limits);
+        totalNodes += result.nodes;
+        pawnProbes += result.pawnHashProbes;
+        pawnHits += result.pawnHashHits;
+
+        // Effective branching factor: the per-ply growth that would give this many nodes at this depth
+        double ebf = std::pow(double(std::max<uint64_t>(result.nodes, 1)), 1.0 / std::max(depth, 1));
+        logEbfSum += std::log(ebf);
+        ++positions;
+
+        std::cout << fen << "\n  best " << moveToNotation(result.move) << " eval " << result.evaluation
+                  << " nodes " << result.nodes << " ebf " << ebf << "\n";
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Eval: " << (nnueEnabled ? std::string("NNUE (") + nnueSimdName() + ")" : std::string("classical"))
+              << "  Threads: " << searchThreads << "  Depth: " << depth << "  Nodes: " << totalNodes
+              << "  Time: " << int(seconds * 1000) << " ms"
+              << "  NPS: " << uint64_t(totalNodes / std::max(seconds, 1e-9))
+              << "  EBF: " << std::exp(logEbfSum / std::max(positions, 1))
+              << "  Pawn hash hits: " << 100.0 * pawnHits / std::max<uint64_t>(pawnProbes, 1) << "%\n";
+    return 0;
+}
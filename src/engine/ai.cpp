@@ -1,34 +1,102 @@
 #include "ai.h"
 #include "board.h"
 #include "evaluation.h"
+#include "utils.h"
+#include "tt.h"
+#include "movepick.h"
+#include "pawns.h"
 #include <algorithm>
 
 #include <iostream>
+#include <cmath>
+#include <array>
+#include <chrono>
+#include <thread>
 #include <bitset>
 #include <cstdint>
 #include <vector>
 #include <limits>
-#include <stack>
 #include <random>
-#include <unordered_map>
 
 using namespace std;
 
-stack<uint64_t> zobristHistory; // For undoing Zobrist hashes efficiently
-uint64_t zobristTable[12][64];  // Randomized Zobrist keys for hashing
-unordered_map<uint64_t, pair<int, int>> transpositionTable;
+std::atomic<bool> stopSearch(false);
+bool printSearchInfo = true;
+int searchThreads = 1;
 
-// Initialize Zobrist hashing
-void initializeZobrist() {
-    random_device rd;
-    mt19937_64 gen(rd());
-    uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
+// Killers and history for move ordering, separate for every search thread
+static thread_local SearchHistory searchHistory;
 
-    for (int piece = 0; piece < 12; ++piece) {
-        for (int square = 0; square < 64; ++square) {
-            zobristTable[piece][square] = dist(gen);
+// Nodes searched by this thread that have not yet been added to searchState.nodes
+static thread_local uint64_t threadNodes;
+
+// Limits of the running search, checked every few thousand nodes
+static const uint64_t POLL_INTERVAL = 2048;
+
+// Half-width of the first aspiration window, in centipawns
+static const int ASPIRATION_WINDOW = 25;
+
+// Quiescence search skips a capture that cannot lift the score to alpha even with this much to spare
+static const int DELTA_MARGIN = 200;
+
+// Late move reductions, indexed [depth][move number]: later moves at higher depths are searched
+// shallower, growing with log(depth) * log(move number)
+static const auto lmrReductions = [] {
+    std::array<std::array<int, 64>, 64> table{};
+    for (int depth = 1; depth < 64; ++depth) {
+        for (int moveNumber = 1; moveNumber < 64; ++moveNumber) {
+            table[depth][moveNumber] = int(0.75 + std::log(depth) * std::log(moveNumber) / 2.25);
         }
     }
+    return table;
+}();
+
+// Shared by all search threads
+static struct {
+    std::atomic<uint64_t> nodes;
+    uint64_t nodeLimit;
+    std::chrono::steady_clock::time_point start;
+    int softLimitMs;  // Do not start another iteration after this
+    int hardLimitMs;  // Abort the running iteration after this
+    std::atomic<bool> pondering;  // Time limits are ignored until finishPondering()
+    std::atomic<uint64_t> pawnHashProbes;  // Totals of every thread's pawn table statistics
+    std::atomic<uint64_t> pawnHashHits;
+} searchState;
+
+static int elapsedMs() {
+    return int(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - searchState.start).count());
+}
+
+// Called by every thread each POLL_INTERVAL nodes: publish the node count and check the limits
+static void checkLimits() {
+    uint64_t nodes = searchState.nodes += threadNodes;
+    threadNodes = 0;
+    if ((searchState.nodeLimit && nodes >= searchState.nodeLimit) ||
+        (searchState.hardLimitMs && !searchState.pondering && elapsedMs() >= searchState.hardLimitMs)) {
+        stopSearch = true;
+    }
+}
+
+// Split the remaining clock into a target for this move and a hard cap
+static void allocateTime(const SearchLimits& limits, bool isWhite) {
+    searchState.softLimitMs = searchState.hardLimitMs = 0;
+    if (limits.infinite) return;
+
+    if (limits.movetime > 0) {
+        searchState.softLimitMs = searchState.hardLimitMs = limits.movetime;
+        return;
+    }
+
+    int time = isWhite ? limits.wtime : limits.btime;
+    int inc = isWhite ? limits.winc : limits.binc;
+    if (time <= 0) return;
+
+    // Plan for about 30 more moves; each iteration takes several times longer than the last,
+    // so only start a new one while under half the target
+    int target = time / 30 + inc * 3 / 4;
+    searchState.softLimitMs = std::max(1, target / 2);
+    searchState.hardLimitMs = std::max(1, std::min(target * 2, time / 4 + inc / 2));
 }
 
 // Define a function to get the maximum evaluation
@@ -40,157 +108,394 @@ int max(int a, int b) {
 int min(int a, int b) {
     return (a < b) ? a : b;
 }
-bool isCapture(uint64_t move, bool isWhiteTurn) {
-    uint64_t targetSquare = move; // Assume `move` encodes the target square
-    uint64_t opponentPieces = isWhiteTurn ? blackPieces : whitePieces;
-    return targetSquare & opponentPieces;
+// Evaluation from the side to move's point of view
+static int evaluateForSideToMove(const Position& pos) {
+    int eval = evaluatePosition(pos);
+    return pos.whiteToMove ? eval : -eval;
 }
 
-bool isCheck(uint64_t move, bool isWhiteTurn) {
-    saveBoardState(isWhiteTurn);
-    makeMove(move, move, isWhiteTurn);
-
-    uint64_t king = isWhiteTurn ? blackKing : whiteKing;
-    bool result = isSquareAttacked(king, !isWhiteTurn);
-
-    undoMove(); // Revert to the original state
-    return result;
+// Mate scores count plies from the root, but a table entry can be reached at any ply, so they
+// are stored relative to the node and converted back when read
+static int scoreToTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score + ply;
+    if (score <= -MATE_BOUND) return score - ply;
+    return score;
 }
 
-int movePriority(uint64_t move, bool isWhiteTurn) {
-    int priority = 0;
-    if (isCapture(move, isWhiteTurn)) {
-        priority += 100; // High priority for captures
-    }
-    if (isCheck(move, isWhiteTurn)) {
-        priority += 50; // Moderate priority for checks
-    }
-    return priority;
+static int scoreFromTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score - ply;
+    if (score <= -MATE_BOUND) return score + ply;
+    return score;
 }
 
-// Recursive minimax function with alpha-beta pruning
-int minimax(int depth, bool isMaximizingPlayer, int alpha, int beta, bool isWhiteTurn) {
-    uint64_t zobristHash = zobristHistory.top(); // Retrieve current Zobrist hash
+// Quiescence search: resolve captures and promotions at the leaves so the static evaluation
+// is never taken in the middle of an exchange
+int quiescence(Position& pos, int alpha, int beta) {
+    if (++threadNodes == POLL_INTERVAL) checkLimits();
+    if (stopSearch) return 0;
+
+    // Stand pat: the side to move can usually do at least as well as the static evaluation
+    int standPat = evaluateForSideToMove(pos);
+    if (standPat >= beta) return standPat;
+    if (standPat > alpha) alpha = standPat;
+
+    // Captures and promotions by MVV-LVA; the picker already drops losing captures
+    MovePicker picker(pos);
+    int bestEval = standPat;
+    Move move;
+    while ((move = picker.next()) != NO_MOVE) {
+        // Delta pruning: even winning the captured piece outright would not reach alpha
+        if (moveFlag(move) != MOVE_PROMOTION) {
+            int victim = moveFlag(move) == MOVE_EN_PASSANT ? PAWN : pos.pieceTypeAt(moveTo(move));
+            if (standPat + PIECE_VALUES[victim] + DELTA_MARGIN <= alpha) continue;
+        }
+
+        UndoInfo undo = makeMove(pos, move);
+        int eval = -quiescence(pos, -beta, -alpha);
+        unmakeMove(pos, move, undo);
 
-    // Check transposition table
-    if (transpositionTable.count(zobristHash)) {
-        auto [storedDepth, storedEval] = transpositionTable[zobristHash];
-        if (storedDepth >= depth) {
-            return storedEval; // Use cached evaluation
+        if (stopSearch) return 0;
+
+        if (eval > bestEval) {
+            bestEval = eval;
+            if (eval > alpha) alpha = eval;
+            if (alpha >= beta) break;
         }
     }
+    return bestEval;
+}
+
+// Whether a side has anything besides pawns and the king; null move pruning is unsafe without
+// it, since pawn endings are where zugzwang (every move makes things worse) is common
+static bool hasNonPawnMaterial(const Position& pos, int side) {
+    return pos.pieces[side][KNIGHT] | pos.pieces[side][BISHOP] | pos.pieces[side][ROOK] | pos.pieces[side][QUEEN];
+}
 
-    // Base case: if depth is 0 or the game is over
-    if (depth == 0 || isCheckmateOrStalemate(isWhiteTurn)) {
-        return evaluatePosition();
+// Negamax alpha-beta with principal variation search. Scores are from the side to move's
+// point of view. The first move gets the full window; the rest are searched with a null
+// window around alpha and only re-searched in full if they turn out better.
+int negamax(Position& pos, int depth, int alpha, int beta, int ply, bool allowNull) {
+    if (++threadNodes == POLL_INTERVAL) checkLimits();
+    if (stopSearch) return 0;
+
+    // Repetitions and the fifty-move rule end the line in a draw, whatever the table says
+    if (isDraw(pos)) return 0;
+
+    int alphaOrig = alpha;
+
+    // Check transposition table; a stored bound is only usable if it falls outside the window
+    TTData ttData;
+    Move ttMove = NO_MOVE;
+    if (transpositionTable.probe(pos.key, ttData)) {
+        ttMove = ttData.move;
+        ttData.score = scoreFromTT(ttData.score, ply);
+        if (ttData.depth >= depth &&
+            (ttData.bound == BOUND_EXACT ||
+             (ttData.bound == BOUND_LOWER && ttData.score >= beta) ||
+             (ttData.bound == BOUND_UPPER && ttData.score <= alpha))) {
+            return ttData.score;
+        }
     }
 
-    std::vector<uint64_t> legalMoves;
-    int bestEval = isMaximizingPlayer ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
-
-    // Generate all moves for the current player
-    uint64_t pieces = isWhiteTurn ? whitePieces : blackPieces;
-    while (pieces) {
-        uint64_t piece = pieces & -pieces; // Isolate least significant bit
-        pieces &= pieces - 1;
-
-        if (isWhiteTurn) {
-            if (whitePawns & piece) legalMoves = generatePawnMoves(piece, true);
-            else if (whiteKnights & piece) legalMoves = generateKnightMoves(piece, true);
-            else if (whiteBishops & piece) legalMoves = generateBishopMoves(piece, true);
-            else if (whiteRooks & piece) legalMoves = generateRookMoves(piece, true);
-            else if (whiteQueens & piece) legalMoves = generateQueenMoves(piece, true);
-            else if (whiteKing & piece) legalMoves = generateKingMoves(piece, true);
-        } else {
-            if (blackPawns & piece) legalMoves = generatePawnMoves(piece, false);
-            else if (blackKnights & piece) legalMoves = generateKnightMoves(piece, false);
-            else if (blackBishops & piece) legalMoves = generateBishopMoves(piece, false);
-            else if (blackRooks & piece) legalMoves = generateRookMoves(piece, false);
-            else if (blackQueens & piece) legalMoves = generateQueenMoves(piece, false);
-            else if (blackKing & piece) legalMoves = generateKingMoves(piece, false);
+    // Resolve captures at the horizon
+    if (depth == 0) return quiescence(pos, alpha, beta);
+
+    bool pvNode = beta - alpha > 1;
+    bool inCheck = isInCheck(pos);
+
+    // Null move pruning: if passing the turn still fails high on a reduced search, a real move
+    // almost certainly would too. Not in PV nodes, in check, right after another null move or
+    // with only pawns left.
+    if (!pvNode && allowNull && !inCheck && depth >= 3 && hasNonPawnMaterial(pos, pos.whiteToMove ? WHITE : BLACK)) {
+        int staticEval = evaluateForSideToMove(pos);
+        if (staticEval >= beta) {
+            // Reduce more at higher depths and when far above beta
+            int reduction = 3 + depth / 6 + std::min((staticEval - beta) / 200, 3);
+            UndoInfo undo = makeNullMove(pos);
+            int eval = -negamax(pos, std::max(depth - 1 - reduction, 0), -beta, -beta + 1, ply + 1, false);
+            unmakeNullMove(pos, undo);
+
+            if (stopSearch) return 0;
+            // A mate found after passing is not proven, so only claim beta
+            if (eval >= beta) return eval >= MATE_BOUND ? beta : eval;
         }
+    }
 
-        // Move ordering: prioritize captures or checks
-        sort(legalMoves.begin(), legalMoves.end(), [isWhiteTurn](uint64_t a, uint64_t b) {
-            return movePriority(a, isWhiteTurn) > movePriority(b, isWhiteTurn);
-        });
+    // Moves come out staged: TT move, good captures, killers, quiets by history, bad captures
+    MovePicker picker(pos, ttMove, searchHistory, ply);
 
-        for (uint64_t move : legalMoves) {
-            if (!isMoveLegal(piece, move, isWhiteTurn)) continue;
+    int bestEval = -INFINITE_SCORE;
+    Move bestMove = NO_MOVE;
+    Move quietsTried[MAX_MOVES];
+    int quietCount = 0;
+    int moveCount = 0;
 
-            saveBoardState(isWhiteTurn);
-            makeMove(piece, move, isWhiteTurn);
+    Move move;
+    while ((move = picker.next()) != NO_MOVE) {
+        bool quiet = !isCapture(pos, move) && moveFlag(move) != MOVE_PROMOTION;
+        UndoInfo undo = makeMove(pos, move);
 
-            int eval;
-            if (isMaximizingPlayer) {
-                eval = minimax(depth - 1, false, alpha, beta, !isWhiteTurn);
-                bestEval = std::max(bestEval, eval);
-                alpha = std::max(alpha, eval);
-            } else {
-                eval = minimax(depth - 1, true, alpha, beta, !isWhiteTurn);
-                bestEval = std::min(bestEval, eval);
-                beta = std::min(beta, eval);
+        int eval;
+        if (moveCount == 0) {
+            eval = -negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+        } else {
+            // Late move reductions: quiet moves from the fourth on (moveCount counts the moves
+            // already searched) are searched shallower first
+            int reduction = 0;
+            if (depth >= 3 && moveCount >= 3 && quiet && !inCheck && !isInCheck(pos)) {
+                reduction = lmrReductions[std::min(depth, 63)][std::min(moveCount, 63)];
+                if (pvNode) --reduction;
+                reduction = std::clamp(reduction, 0, depth - 2);
             }
 
-            undoMove();
+            eval = -negamax(pos, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+            if (reduction > 0 && eval > alpha) eval = -negamax(pos, depth - 1, -alpha - 1, -alpha, ply + 1);
+            if (eval > alpha && eval < beta) eval = -negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+        }
+        ++moveCount;
+
+        unmakeMove(pos, move, undo);
+
+        // An aborted search returns garbage; the caller throws it away
+        if (stopSearch) return 0;
 
-            if (beta <= alpha) {
-                break; // Alpha-beta cutoff
+        if (eval > bestEval) {
+            bestEval = eval;
+            bestMove = move;
+            if (eval > alpha) alpha = eval;
+            if (alpha >= beta) {
+                // Beta cutoff
+                if (quiet) searchHistory.updateQuietCutoff(pos, move, ply, depth, quietsTried, quietCount);
+                break;
             }
         }
+        if (quiet) quietsTried[quietCount++] = move;
     }
 
-    // Store result in transposition table
-    transpositionTable[zobristHash] = std::make_pair(depth, bestEval);
+    // No legal move: checkmate (sooner is worse) or stalemate
+    if (moveCount == 0) return inCheck ? -MATE_SCORE + ply : 0;
+
+    // Store result in transposition table, with the bound it represents for the original window
+    int bound = bestEval <= alphaOrig ? BOUND_UPPER : bestEval >= beta ? BOUND_LOWER : BOUND_EXACT;
+    transpositionTable.store(pos.key, depth, scoreToTT(bestEval, ply), bound, bestMove);
 
     return bestEval;
 }
 
-// Function to find the best move for the computer
-Move findBestMove(bool isWhiteTurn, int depth) {
-    Move bestMove = {0, 0, isWhiteTurn ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max()};
-    uint64_t pieces = isWhiteTurn ? whitePieces : blackPieces;
+// Search every root move at one depth within a window, best move first. Returns the best score,
+// or a bound on it if the result falls outside the window.
+static int searchRoot(Position& pos, MoveList& moves, int depth, int alpha, int beta, Move& bestMove) {
+    int bestEval = -INFINITE_SCORE;
+    for (int i = 0; i < moves.size(); ++i) {
+        Move move = moves[i];
+        UndoInfo undo = makeMove(pos, move);
+
+        int eval;
+        if (i == 0) {
+            eval = -negamax(pos, depth - 1, -beta, -alpha, 1);
+        } else {
+            eval = -negamax(pos, depth - 1, -alpha - 1, -alpha, 1);
+            if (eval > alpha && eval < beta) eval = -negamax(pos, depth - 1, -beta, -alpha, 1);
+        }
 
-    while (pieces) {
-        uint64_t piece = pieces & -pieces;
-        pieces &= pieces - 1;
+        unmakeMove(pos, move, undo);
+        if (stopSearch) break;
 
-        std::vector<uint64_t> legalMoves;
-        if (isWhiteTurn) {
-            if (whitePawns & piece) legalMoves = generatePawnMoves(piece, true);
-            else if (whiteKnights & piece) legalMoves = generateKnightMoves(piece, true);
-            else if (whiteBishops & piece) legalMoves = generateBishopMoves(piece, true);
-            else if (whiteRooks & piece) legalMoves = generateRookMoves(piece, true);
-            else if (whiteQueens & piece) legalMoves = generateQueenMoves(piece, true);
-            else if (whiteKing & piece) legalMoves = generateKingMoves(piece, true);
-        } else {
-            if (blackPawns & piece) legalMoves = generatePawnMoves(piece, false);
-            else if (blackKnights & piece) legalMoves = generateKnightMoves(piece, false);
-            else if (blackBishops & piece) legalMoves = generateBishopMoves(piece, false);
-            else if (blackRooks & piece) legalMoves = generateRookMoves(piece, false);
-            else if (blackQueens & piece) legalMoves = generateQueenMoves(piece, false);
-            else if (blackKing & piece) legalMoves = generateKingMoves(piece, false);
+        if (eval > bestEval) {
+            bestEval = eval;
+            if (eval > alpha) {
+                bestMove = move;
+                alpha = eval;
+                if (alpha >= beta) break;
+            }
         }
+    }
+    return bestEval;
+}
 
-        for (uint64_t move : legalMoves) {
-            if (!isMoveLegal(piece, move, isWhiteTurn)) continue;
+// Iterative deepening: search depth 1, 2, 3... until a limit is hit, trying the previous
+// iteration's best move first. From depth 4 on, each iteration starts with a narrow
+// aspiration window around the previous score and widens it on a fail high or low.
+// Every search thread runs this on its own copy of the position; helpers (threadId > 0)
+// start at a different depth so the threads spread over more of the tree.
+static SearchResult iterativeDeepening(const Position& root, const SearchLimits& limits, int threadId) {
+    Position pos = root;
+    bool isWhiteTurn = pos.whiteToMove;
+    bool mainThread = threadId == 0;
+    searchHistory.newSearch();
+    threadNodes = 0;
+    pawnHashStats() = {};
+
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+
+    SearchResult result = {NO_MOVE, 0, 0, 0, NO_MOVE};
+    if (moves.empty()) return result;
+    result.move = moves[0];
+
+    int score = 0;
+    int maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_DEPTH) : MAX_DEPTH;
+    for (int depth = 1 + threadId % 2; depth <= maxDepth; ++depth) {
+        // Search the previous best move first so the window narrows early
+        std::stable_partition(moves.begin(), moves.end(), [&](Move m) { return m == result.move; });
+
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+        if (depth >= 4) {
+            alpha = std::max(score - delta, -INFINITE_SCORE);
+            beta = std::min(score + delta, int(INFINITE_SCORE));
+        }
+
+        Move bestMove = NO_MOVE;
+        int eval;
+        while (true) {
+            Move iterationBest = result.move;
+            eval = searchRoot(pos, moves, depth, alpha, beta, iterationBest);
+            if (stopSearch) break;
+
+            if (eval <= alpha) {
+                // Fail low: nothing reached the window, so lower it
+                alpha = std::max(eval - delta, -INFINITE_SCORE);
+            } else if (eval >= beta) {
+                // Fail high: keep the refuting move at the front and raise the window
+                beta = std::min(eval + delta, int(INFINITE_SCORE));
+                std::stable_partition(moves.begin(), moves.end(), [&](Move m) { return m == iterationBest; });
+            } else {
+                bestMove = iterationBest;
+                break;
+            }
+            delta *= 2;
+        }
 
-            saveBoardState(isWhiteTurn);
-            makeMove(piece, move, isWhiteTurn);
+        // Only a completed iteration is trusted
+        if (stopSearch) break;
 
-            int eval = minimax(depth - 1, !isWhiteTurn, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), !isWhiteTurn);
-            undoMove();
+        score = eval;
+        result = {bestMove, isWhiteTurn ? score : -score, depth, 0, NO_MOVE};
+        if (!mainThread) continue;
 
-            std::cout << "Move from " << squareToNotation(piece) << " to " << squareToNotation(move)
-                      << " evaluated at " << eval << std::endl;
+        if (printSearchInfo && !searchState.pondering) {
+            std::cout << "depth " << depth << " score " << score << " nodes " << searchState.nodes + threadNodes
+                      << " time " << elapsedMs() << " ms best " << moveToNotation(bestMove) << std::endl;
+        }
 
-            if ((isWhiteTurn && eval > bestMove.evaluation) || (!isWhiteTurn && eval < bestMove.evaluation)) {
-                bestMove = {piece, move, eval};
-            }
+        if (limits.infinite || searchState.pondering) continue;
+        if (searchState.softLimitMs && elapsedMs() >= searchState.softLimitMs) break;
+    }
+
+    searchState.nodes += threadNodes;
+    threadNodes = 0;
+    searchState.pawnHashProbes += pawnHashStats().probes;
+    searchState.pawnHashHits += pawnHashStats().hits;
+    return result;
+}
+
+// Reset the shared state for a new search; done on the caller's thread so a ponder search is
+// fully set up before its thread starts
+static void prepareSearch(const Position& pos, const SearchLimits& limits) {
+    transpositionTable.newSearch();
+
+    stopSearch = false;
+    searchState.nodes = 0;
+    searchState.pawnHashProbes = searchState.pawnHashHits = 0;
+    searchState.nodeLimit = limits.nodes;
+    searchState.start = std::chrono::steady_clock::now();
+    allocateTime(limits, pos.whiteToMove);
+    searchState.pondering = limits.ponder;
+}
+
+// Lazy SMP: start searchThreads - 1 helpers that search the same position and share only the
+// transposition table. The main thread decides when to stop and reports the deepest result.
+static SearchResult runSearch(Position& pos, const SearchLimits& limits) {
+    std::vector<SearchResult> helperResults(std::max(searchThreads, 1) - 1);
+    std::vector<std::thread> helpers;
+    for (int i = 0; i < int(helperResults.size()); ++i) {
+        helpers.emplace_back([&, i]() { helperResults[i] = iterativeDeepening(pos, limits, i + 1); });
+    }
+
+    SearchResult result = iterativeDeepening(pos, limits, 0);
+
+    // An infinite search only ends when it is told to, and a ponder search may not move before
+    // the opponent does
+    while ((limits.infinite || searchState.pondering) && !stopSearch) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    stopSearch = true;
+    for (std::thread& helper : helpers) helper.join();
+
+    // Prefer a helper's result only if it completed a deeper iteration
+    for (const SearchResult& helperResult : helperResults) {
+        if (helperResult.move != NO_MOVE && helperResult.depth > result.depth) result = helperResult;
+    }
+
+    result.nodes = searchState.nodes;
+    result.pawnHashProbes = searchState.pawnHashProbes;
+    result.pawnHashHits = searchState.pawnHashHits;
+
+    // The reply to expect is the table's best move in the position after ours
+    if (result.move != NO_MOVE) {
+        UndoInfo undo = makeMove(pos, result.move);
+        TTData ttData;
+        if (transpositionTable.probe(pos.key, ttData) && ttData.move != NO_MOVE && isLegalMove(pos, ttData.move)) {
+            result.ponderMove = ttData.move;
         }
+        unmakeMove(pos, result.move, undo);
+    }
+
+    // A ponder search that was abandoned has nothing to report
+    if (printSearchInfo && !searchState.pondering) {
+        std::cout << "Best move selected: " << moveToNotation(result.move)
+                  << " with evaluation " << result.evaluation << " (pawn hash hits "
+                  << 100 * result.pawnHashHits / std::max<uint64_t>(result.pawnHashProbes, 1) << "%)" << std::endl;
     }
+    return result;
+}
 
-    std::cout << "Best move selected: from " << squareToNotation(bestMove.from) << " to " << squareToNotation(bestMove.to)
-              << " with evaluation " << bestMove.evaluation << std::endl;
-    return bestMove;
-}
\ No newline at end of file
+SearchResult findBestMove(Position& pos, const SearchLimits& limits) {
+    prepareSearch(pos, limits);
+    return runSearch(pos, limits);
+}
+
+// Background search of the position after the expected reply
+static struct {
+    std::thread thread;
+    Position pos;           // Owned by the ponder thread while it runs
+    uint64_t expectedKey;   // Key of pos, for the game thread to compare against
+    SearchLimits limits;
+    SearchResult result;
+} ponder;
+
+void startPondering(const Position& pos, Move expectedReply, const SearchLimits& limits) {
+    stopPondering();
+
+    ponder.pos = pos;
+    makeMove(ponder.pos, expectedReply);
+    ponder.expectedKey = ponder.pos.key;
+    ponder.limits = limits;
+    ponder.limits.ponder = true;
+
+    prepareSearch(ponder.pos, ponder.limits);
+    ponder.thread = std::thread([]() { ponder.result = runSearch(ponder.pos, ponder.limits); });
+}
+
+bool finishPondering(const Position& pos, SearchResult& result) {
+    if (!ponder.thread.joinable()) return false;
+    if (pos.key != ponder.expectedKey) {
+        // Ponder miss: the work is lost, apart from what it left in the transposition table
+        stopPondering();
+        return false;
+    }
+
+    // Ponder hit: the search goes on under the real limits, with the time already spent counted
+    searchState.pondering = false;
+    ponder.thread.join();
+    result = ponder.result;
+    return true;
+}
+
+void stopPondering() {
+    if (!ponder.thread.joinable()) return;
+    stopSearch = true;
+    ponder.thread.join();
+}
@@ -1,39 +1,73 @@
 #ifndef AI_H
 #define AI_H
 
-#include <stack>
-#include <unordered_map>
+#include <atomic>
 #include <vector>
 #include <cstdint>
 
-// Structure to represent a move with its evaluation
-struct Move {
-    uint64_t from;
-    uint64_t to;
-    int evaluation;
+#include "board.h"
+#include "move.h"
+
+// Best move found by the search together with its evaluation
+struct SearchResult {
+    Move move;
+    int evaluation;      // Positive if White is better
+    int depth;           // Last fully completed iteration
+    uint64_t nodes;
+    Move ponderMove;     // Expected reply, from the transposition table (NO_MOVE if unknown)
+    uint64_t pawnHashProbes = 0;  // Pawn hash table use by all threads
+    uint64_t pawnHashHits = 0;
+};
+
+const int MAX_DEPTH = 64;
+
+// Larger than any evaluation, and small enough to fit a transposition table entry
+const int INFINITE_SCORE = 32000;
+
+// Score for being checkmated at the root; a mate found N plies from the root scores MATE_SCORE - N,
+// so shorter mates are preferred. Anything beyond MATE_BOUND is a mate score.
+const int MATE_SCORE = 31000;
+const int MATE_BOUND = MATE_SCORE - 1000;
+
+// When to stop searching; zero means no limit. Times are in milliseconds.
+struct SearchLimits {
+    int depth = 0;
+    uint64_t nodes = 0;
+    int movetime = 0;
+    int wtime = 0, btime = 0;
+    int winc = 0, binc = 0;
+    bool infinite = false;  // Search until stopSearch is set from outside
+    bool ponder = false;    // Ignore the time limits until the expected reply is played (set by startPondering)
 };
 
-// Zobrist hashing
-extern std::stack<uint64_t> zobristHistory;
-extern uint64_t zobristTable[12][64];
-extern std::unordered_map<uint64_t, std::pair<int, int>> transpositionTable;
+// Set to end the current search; the best move of the last completed iteration is returned
+extern std::atomic<bool> stopSearch;
 
-// Zobrist initialization
-void initializeZobrist();
+// Number of search threads (Lazy SMP); 1 searches on the calling thread only
+extern int searchThreads;
+
+// Print a line per completed iteration and the chosen move (on by default)
+extern bool printSearchInfo;
 
 // Utility functions
 int max(int a, int b);
 int min(int a, int b);
 
-// Move evaluation helpers
-bool isCapture(uint64_t move, bool isWhiteTurn);
-bool isCheck(uint64_t move, bool isWhiteTurn);
-int movePriority(uint64_t move, bool isWhiteTurn);
+// Captures-only search at the leaves
+int quiescence(Position& pos, int alpha, int beta);
+
+// Negamax alpha-beta with principal variation search (score for the side to move)
+int negamax(Position& pos, int depth, int alpha, int beta, int ply, bool allowNull = true);
 
-// Minimax algorithm with alpha-beta pruning
-int minimax(int depth, bool isMaximizingPlayer, int alpha, int beta, bool isWhiteTurn);
+// AI interface: iterative deepening within the given limits
+SearchResult findBestMove(Position& pos, const SearchLimits& limits);
 
-// AI interface
-Move findBestMove(bool isWhiteTurn, int depth);
+// Pondering: search the position after the expected reply on the opponent's time. Once the
+// opponent has moved, finishPondering either keeps the search going under the real time limits
+// (counted from when pondering started) and returns its result, or, if a different move was
+// played, aborts it and returns false.
+void startPondering(const Position& pos, Move expectedReply, const SearchLimits& limits);
+bool finishPondering(const Position& pos, SearchResult& result);
+void stopPondering();
 
 #endif // AI_H
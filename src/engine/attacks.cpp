@@ -0,0 +1,137 @@
+#include "attacks.h"
+
+#include <cstdint>
+#include <vector>
+
+Magic rookMagics[64];
+Magic bishopMagics[64];
+
+uint64_t betweenSquares[64][64];
+uint64_t lineThrough[64][64];
+
+// Shared attack tables, indexed through each square's Magic entry
+static uint64_t rookTable[0x19000];  // 102400 entries
+static uint64_t bishopTable[0x1480]; // 5248 entries
+
+static const int rookDirections[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+static const int bishopDirections[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+// Walk each ray square by square until it leaves the board or hits a blocker.
+// Only used while building the tables.
+static uint64_t slidingAttacks(int square, uint64_t occupied, const int directions[4][2]) {
+    uint64_t attacks = 0;
+    for (int d = 0; d < 4; ++d) {
+        int file = square % 8 + directions[d][0];
+        int rank = square / 8 + directions[d][1];
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            uint64_t bit = 1ULL << (rank * 8 + file);
+            attacks |= bit;
+            if (occupied & bit) break;
+            file += directions[d][0];
+            rank += directions[d][1];
+        }
+    }
+    return attacks;
+}
+
+// Squares whose occupancy affects the attacks (the last square of each ray never matters)
+static uint64_t relevantMask(int square, const int directions[4][2]) {
+    uint64_t mask = 0;
+    for (int d = 0; d < 4; ++d) {
+        int file = square % 8 + directions[d][0];
+        int rank = square / 8 + directions[d][1];
+        while (file + directions[d][0] >= 0 && file + directions[d][0] < 8 &&
+               rank + directions[d][1] >= 0 && rank + directions[d][1] < 8) {
+            mask |= 1ULL << (rank * 8 + file);
+            file += directions[d][0];
+            rank += directions[d][1];
+        }
+    }
+    return mask;
+}
+
+// Xorshift generator, reseeded per rank with values known to find magics quickly
+static uint64_t randomState;
+static const uint64_t rankSeeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+static uint64_t random64() {
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return randomState * 2685821657736338717ULL;
+}
+
+// Magic candidates work best with few bits set
+static uint64_t sparseRandom64() {
+    return random64() & random64() & random64();
+}
+
+// Find a collision-free magic for every square and fill in its attack table slice
+static void initializeMagics(Magic magics[64], uint64_t* table, const int directions[4][2]) {
+    std::vector<uint64_t> occupancies(4096), references(4096);
+    std::vector<int> epoch(4096, 0);
+    int attempt = 0;
+
+    for (int square = 0; square < 64; ++square) {
+        Magic& m = magics[square];
+        m.mask = relevantMask(square, directions);
+        m.shift = 64 - __builtin_popcountll(m.mask);
+        m.attacks = table;
+
+        // Enumerate every subset of the mask (Carry-Rippler trick)
+        int size = 0;
+        uint64_t subset = 0;
+        do {
+            occupancies[size] = subset;
+            references[size] = slidingAttacks(square, subset, directions);
+            ++size;
+            subset = (subset - m.mask) & m.mask;
+        } while (subset);
+
+        randomState = rankSeeds[square / 8];
+
+        // Try random candidates until one maps every subset without a harmful collision
+        bool found = false;
+        while (!found) {
+            m.magic = sparseRandom64();
+            if (__builtin_popcountll((m.mask * m.magic) >> 56) < 6) continue;
+
+            ++attempt;
+            found = true;
+            for (int i = 0; i < size; ++i) {
+                unsigned index = (occupancies[i] * m.magic) >> m.shift;
+                if (epoch[index] < attempt) {
+                    epoch[index] = attempt;
+                    m.attacks[index] = references[i];
+                } else if (m.attacks[index] != references[i]) {
+                    found = false;
+                    break;
+                }
+            }
+        }
+
+        table += size;
+    }
+}
+
+// Build the rook and bishop attack tables and the between/line tables (call once at startup)
+void initializeAttackTables() {
+    initializeMagics(rookMagics, rookTable, rookDirections);
+    initializeMagics(bishopMagics, bishopTable, bishopDirections);
+
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            uint64_t aBit = 1ULL << a, bBit = 1ULL << b;
+            betweenSquares[a][b] = lineThrough[a][b] = 0;
+            if (a == b) continue;
+
+            if (rookAttacks(a, 0) & bBit) {
+                betweenSquares[a][b] = rookAttacks(a, bBit) & rookAttacks(b, aBit);
+                lineThrough[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | aBit | bBit;
+            } else if (bishopAttacks(a, 0) & bBit) {
+                betweenSquares[a][b] = bishopAttacks(a, bBit) & bishopAttacks(b, aBit);
+                lineThrough[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | aBit | bBit;
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include <array>
+#include <cstdint>
+
+#include "../constants.h"
+
+// Leaper attack tables, generated at compile time
+constexpr std::array<uint64_t, 64> makeKnightAttacks() {
+    std::array<uint64_t, 64> table{};
+    for (int sq = 0; sq < 64; ++sq) {
+        uint64_t knight = 1ULL << sq;
+        table[sq] = ((knight << 17) & ~FILE_A) | ((knight << 15) & ~FILE_H) |
+                    ((knight << 10) & ~(FILE_A | FILE_B)) | ((knight << 6) & ~(FILE_G | FILE_H)) |
+                    ((knight >> 17) & ~FILE_H) | ((knight >> 15) & ~FILE_A) |
+                    ((knight >> 10) & ~(FILE_G | FILE_H)) | ((knight >> 6) & ~(FILE_A | FILE_B));
+    }
+    return table;
+}
+
+constexpr std::array<uint64_t, 64> makeKingAttacks() {
+    std::array<uint64_t, 64> table{};
+    for (int sq = 0; sq < 64; ++sq) {
+        uint64_t king = 1ULL << sq;
+        table[sq] = (king << 8) | (king >> 8) |
+                    ((king & ~FILE_H) << 1) | ((king & ~FILE_A) >> 1) |
+                    ((king & ~FILE_H) << 9) | ((king & ~FILE_A) << 7) |
+                    ((king & ~FILE_H) >> 7) | ((king & ~FILE_A) >> 9);
+    }
+    return table;
+}
+
+// Indexed by the colour of the attacking pawn (WHITE or BLACK)
+constexpr std::array<std::array<uint64_t, 64>, 2> makePawnAttacks() {
+    std::array<std::array<uint64_t, 64>, 2> table{};
+    for (int sq = 0; sq < 64; ++sq) {
+        uint64_t pawn = 1ULL << sq;
+        table[WHITE][sq] = ((pawn & ~FILE_A) << 7) | ((pawn & ~FILE_H) << 9);
+        table[BLACK][sq] = ((pawn & ~FILE_H) >> 7) | ((pawn & ~FILE_A) >> 9);
+    }
+    return table;
+}
+
+inline constexpr std::array<uint64_t, 64> KNIGHT_ATTACKS = makeKnightAttacks();
+inline constexpr std::array<uint64_t, 64> KING_ATTACKS = makeKingAttacks();
+inline constexpr std::array<std::array<uint64_t, 64>, 2> PAWN_ATTACKS = makePawnAttacks();
+
+// Magic bitboard entry for a single square
+struct Magic {
+    uint64_t mask;      // Relevant blocker squares (board edges excluded)
+    uint64_t magic;     // Multiplier that hashes the blockers into a table index
+    uint64_t* attacks;  // This square's slice of the shared attack table
+    int shift;          // 64 - number of relevant blocker squares
+};
+
+extern Magic rookMagics[64];
+extern Magic bishopMagics[64];
+
+// Squares strictly between two squares on a shared rank, file or diagonal (0 otherwise)
+extern uint64_t betweenSquares[64][64];
+// The whole rank, file or diagonal through two squares, including both (0 if not aligned)
+extern uint64_t lineThrough[64][64];
+
+// Build the rook and bishop attack tables and the between/line tables (call once at startup)
+void initializeAttackTables();
+
+// Sliding piece attacks from a square, given the occupied squares
+inline uint64_t rookAttacks(int square, uint64_t occupied) {
+    const Magic& m = rookMagics[square];
+    return m.attacks[((occupied & m.mask) * m.magic) >> m.shift];
+}
+
+inline uint64_t bishopAttacks(int square, uint64_t occupied) {
+    const Magic& m = bishopMagics[square];
+    return m.attacks[((occupied & m.mask) * m.magic) >> m.shift];
+}
+
+inline uint64_t queenAttacks(int square, uint64_t occupied) {
+    return rookAttacks(square, occupied) | bishopAttacks(square, occupied);
+}
+
+#endif // ATTACKS_H
@@ -1,4 +1,6 @@
 #include "board.h"
+#include "attacks.h"
+#include "psqt.h"
 #include "../constants.h"
 
 #include <iostream>
@@ -6,122 +8,241 @@
 #include <cstdint>
 #include <vector>
 #include <algorithm>
+#include <array>
 
-#include <stack>
 #include <random>
-#include <unordered_map>
+#include <sstream>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
 
 using namespace std;
-// Initialize the global board instance
-Board b;
-
-// Board state
-uint64_t whitePawns, whiteKnights, whiteBishops, whiteRooks, whiteQueens, whiteKing;
-uint64_t blackPawns, blackKnights, blackBishops, blackRooks, blackQueens, blackKing;
-uint64_t whitePieces, blackPieces, allPieces;
-bool whiteKingsideCastle = true, whiteQueensideCastle = true;
-bool blackKingsideCastle = true, blackQueensideCastle = true;
-uint64_t enPassantTarget = 0;
 
 // Zobrist hashing
-std::stack<uint64_t> zobristHistory;
 uint64_t zobristTable[12][64];
-std::unordered_map<uint64_t, std::pair<int, int>> transpositionTable;
+uint64_t zobristSide;
+uint64_t zobristCastling[16];
+uint64_t zobristEnPassant[8];
+
+// Castling rights kept when a move touches each square (king and rook home squares clear rights)
+static constexpr std::array<int, 64> makeCastlingMask() {
+    std::array<int, 64> mask{};
+    for (int sq = 0; sq < 64; ++sq) mask[sq] = 15;
+    mask[4] &= ~(WHITE_KINGSIDE | WHITE_QUEENSIDE);
+    mask[7] &= ~WHITE_KINGSIDE;
+    mask[0] &= ~WHITE_QUEENSIDE;
+    mask[60] &= ~(BLACK_KINGSIDE | BLACK_QUEENSIDE);
+    mask[63] &= ~BLACK_KINGSIDE;
+    mask[56] &= ~BLACK_QUEENSIDE;
+    return mask;
+}
+
+static constexpr std::array<int, 64> castlingMask = makeCastlingMask();
 
-// Initialize Zobrist hashing
+// Initialize Zobrist hashing (fixed seed, so keys are the same on every run)
 void initializeZobrist() {
-    random_device rd;
-    mt19937_64 gen(rd());
-    uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
+    mt19937_64 gen(0x9E3779B97F4A7C15ULL);
 
     for (int piece = 0; piece < 12; ++piece) {
         for (int square = 0; square < 64; ++square) {
-            zobristTable[piece][square] = dist(gen);
+            zobristTable[piece][square] = gen();
         }
     }
+    zobristSide = gen();
+    for (int rights = 0; rights < 16; ++rights) zobristCastling[rights] = gen();
+    for (int file = 0; file < 8; ++file) zobristEnPassant[file] = gen();
 }
-// Initialize the board to the standard starting position
-void initializePosition() {
-    whitePawns = 0x000000000000FF00ULL;
-    whiteKnights = 0x0000000000000042ULL;
-    whiteBishops = 0x0000000000000024ULL;
-    whiteRooks = 0x0000000000000081ULL;
-    whiteQueens = 0x0000000000000008ULL;
-    whiteKing = 0x0000000000000010ULL;
-
-    blackPawns = 0x00FF000000000000ULL;
-    blackKnights = 0x4200000000000000ULL;
-    blackBishops = 0x2400000000000000ULL;
-    blackRooks = 0x8100000000000000ULL;
-    blackQueens = 0x0800000000000000ULL;
-    blackKing = 0x1000000000000000ULL;
-
-    whitePieces = whitePawns | whiteKnights | whiteBishops | whiteRooks | whiteQueens | whiteKing;
-    blackPieces = blackPawns | blackKnights | blackBishops | blackRooks | blackQueens | blackKing;
-    allPieces = whitePieces | blackPieces;
-
-    whiteKingsideCastle = whiteQueensideCastle = true;
-    blackKingsideCastle = blackQueensideCastle = true;
-    enPassantTarget = 0;
-
-    // Initialize Zobrist hash for the initial position
-    zobristHistory.push(0); // Push an initial Zobrist hash (to be calculated dynamically)
-}
-
-// Sliding piece moves (rooks and bishops), with blockers
-uint64_t slideMove(uint64_t piece, int direction, uint64_t blockers) {
-    uint64_t moves = 0;
-    uint64_t temp = piece;
-
-    while (temp) {
-        temp = (direction > 0) ? (temp << direction) : (temp >> -direction);
-        if (temp & blockers) {  // Stop at blockers
-            moves |= temp;      // Include the blocker square for capture
-            break;
+
+// Hash the whole position from scratch (only needed at setup and for debug checks)
+uint64_t computeKey(const Position& pos) {
+    uint64_t key = 0;
+    for (int side = WHITE; side <= BLACK; ++side) {
+        for (int piece = PAWN; piece <= KING; ++piece) {
+            uint64_t bb = pos.pieces[side][piece];
+            while (bb) {
+                key ^= zobristTable[makePiece(side, piece)][__builtin_ctzll(bb)];
+                bb &= bb - 1;
+            }
         }
-        if ((temp & FILE_A) && (direction == -1 || direction == 7 || direction == -9)) break; // Prevent wrap from H to A
-        if ((temp & FILE_H) && (direction == 1 || direction == -7 || direction == 9)) break;  // Prevent wrap from A to H
-        moves |= temp;
     }
-    return moves;
+    if (!pos.whiteToMove) key ^= zobristSide;
+    key ^= zobristCastling[pos.castlingRights];
+    if (pos.enPassantTarget) key ^= zobristEnPassant[__builtin_ctzll(pos.enPassantTarget) % 8];
+    return key;
 }
 
-// Print a bitboard for debugging purposes
-void printBitboard(uint64_t bitboard) {
-    std::cout << "  a b c d e f g h\n +----------------+\n";
-    for (int rank = 7; rank >= 0; --rank) {
-        std::cout << rank + 1 << "| ";
-        for (int file = 0; file < 8; ++file) {
-            int square = rank * 8 + file;
-            std::cout << (((bitboard >> square) & 1) ? "1 " : ". ");
+#ifdef ZOBRIST_DEBUG
+// Stop at the first key that drifts from a full recompute. Not an assert, so the check also
+// runs in release builds.
+static void verifyKey(const Position& pos, const char* where) {
+    if (pos.key == computeKey(pos)) return;
+    std::cerr << "Zobrist key mismatch after " << where << std::endl;
+    std::abort();
+}
+#endif
+
+// Recompute the occupancy bitboards, the mailbox and the evaluation accumulators from the
+// piece bitboards
+static void updateOccupancy(Position& pos) {
+    std::fill(std::begin(pos.mailbox), std::end(pos.mailbox), NO_PIECE);
+    pos.psqtMidgame = pos.psqtEndgame = pos.phase = 0;
+    pos.pawnKey = 0;
+    for (int side = WHITE; side <= BLACK; ++side) {
+        pos.occupancy[side] = 0;
+        for (int piece = PAWN; piece <= KING; ++piece) {
+            pos.occupancy[side] |= pos.pieces[side][piece];
+            for (uint64_t bb = pos.pieces[side][piece]; bb; bb &= bb - 1) {
+                int sq = __builtin_ctzll(bb);
+                pos.mailbox[sq] = makePiece(side, piece);
+                pos.psqtMidgame += PSQT_MIDGAME[makePiece(side, piece)][sq];
+                pos.psqtEndgame += PSQT_ENDGAME[makePiece(side, piece)][sq];
+                pos.phase += PHASE_WEIGHTS[piece];
+                if (piece == PAWN) pos.pawnKey ^= zobristTable[makePiece(side, piece)][sq];
+            }
         }
-        std::cout << "|\n";
     }
-    std::cout << " +----------------+\n";
+    pos.allPieces = pos.occupancy[WHITE] | pos.occupancy[BLACK];
+    if (nnueEnabled) {
+        nnueRefresh(pos, WHITE);
+        nnueRefresh(pos, BLACK);
+    }
+}
+
+// Incremental board updates shared by makeMove and unmakeMove
+static inline void addPiece(Position& pos, int side, int piece, int sq) {
+    uint64_t bit = 1ULL << sq;
+    pos.pieces[side][piece] |= bit;
+    pos.occupancy[side] |= bit;
+    pos.allPieces |= bit;
+    pos.mailbox[sq] = makePiece(side, piece);
+    pos.key ^= zobristTable[makePiece(side, piece)][sq];
+    pos.psqtMidgame += PSQT_MIDGAME[makePiece(side, piece)][sq];
+    pos.psqtEndgame += PSQT_ENDGAME[makePiece(side, piece)][sq];
+    pos.phase += PHASE_WEIGHTS[piece];
+    if (piece == PAWN) pos.pawnKey ^= zobristTable[makePiece(side, piece)][sq];
+    if (nnueEnabled) nnueAddPiece(pos, side, piece, sq);
+}
+
+static inline void removePiece(Position& pos, int side, int piece, int sq) {
+    uint64_t bit = 1ULL << sq;
+    pos.pieces[side][piece] ^= bit;
+    pos.occupancy[side] ^= bit;
+    pos.allPieces ^= bit;
+    pos.mailbox[sq] = NO_PIECE;
+    pos.key ^= zobristTable[makePiece(side, piece)][sq];
+    pos.psqtMidgame -= PSQT_MIDGAME[makePiece(side, piece)][sq];
+    pos.psqtEndgame -= PSQT_ENDGAME[makePiece(side, piece)][sq];
+    pos.phase -= PHASE_WEIGHTS[piece];
+    if (piece == PAWN) pos.pawnKey ^= zobristTable[makePiece(side, piece)][sq];
+    if (nnueEnabled) nnueRemovePiece(pos, side, piece, sq);
+}
+
+static inline void movePiece(Position& pos, int side, int piece, int from, int to) {
+    uint64_t fromTo = (1ULL << from) | (1ULL << to);
+    pos.pieces[side][piece] ^= fromTo;
+    pos.occupancy[side] ^= fromTo;
+    pos.allPieces ^= fromTo;
+    pos.mailbox[to] = pos.mailbox[from];
+    pos.mailbox[from] = NO_PIECE;
+    pos.key ^= zobristTable[makePiece(side, piece)][from] ^ zobristTable[makePiece(side, piece)][to];
+    pos.psqtMidgame += PSQT_MIDGAME[makePiece(side, piece)][to] - PSQT_MIDGAME[makePiece(side, piece)][from];
+    pos.psqtEndgame += PSQT_ENDGAME[makePiece(side, piece)][to] - PSQT_ENDGAME[makePiece(side, piece)][from];
+    if (piece == PAWN) pos.pawnKey ^= zobristTable[makePiece(side, piece)][from] ^ zobristTable[makePiece(side, piece)][to];
+    if (nnueEnabled) {
+        nnueRemovePiece(pos, side, piece, from);
+        nnueAddPiece(pos, side, piece, to);
+    }
+}
+
+// Initialize the board to the standard starting position
+void initializePosition(Position& pos) {
+    pos.pieces[WHITE][PAWN] = 0x000000000000FF00ULL;
+    pos.pieces[WHITE][KNIGHT] = 0x0000000000000042ULL;
+    pos.pieces[WHITE][BISHOP] = 0x0000000000000024ULL;
+    pos.pieces[WHITE][ROOK] = 0x0000000000000081ULL;
+    pos.pieces[WHITE][QUEEN] = 0x0000000000000008ULL;
+    pos.pieces[WHITE][KING] = 0x0000000000000010ULL;
+
+    pos.pieces[BLACK][PAWN] = 0x00FF000000000000ULL;
+    pos.pieces[BLACK][KNIGHT] = 0x4200000000000000ULL;
+    pos.pieces[BLACK][BISHOP] = 0x2400000000000000ULL;
+    pos.pieces[BLACK][ROOK] = 0x8100000000000000ULL;
+    pos.pieces[BLACK][QUEEN] = 0x0800000000000000ULL;
+    pos.pieces[BLACK][KING] = 0x1000000000000000ULL;
+
+    updateOccupancy(pos);
+
+    pos.castlingRights = WHITE_KINGSIDE | WHITE_QUEENSIDE | BLACK_KINGSIDE | BLACK_QUEENSIDE;
+    pos.enPassantTarget = 0;
+    pos.whiteToMove = true;
+    pos.key = computeKey(pos);
+    pos.halfmoveClock = 0;
+    pos.historyLength = 0;
+}
+
+// Set up a position from a FEN string; returns false (leaving the position unspecified) if it is malformed
+bool setPositionFromFen(Position& pos, const std::string& fen) {
+    std::istringstream stream(fen);
+    std::string placement, side, castling, enPassant;
+    if (!(stream >> placement >> side >> castling >> enPassant)) return false;
+
+    for (int color = WHITE; color <= BLACK; ++color) {
+        for (int piece = PAWN; piece <= KING; ++piece) pos.pieces[color][piece] = 0;
+    }
+
+    int rank = 7, file = 0;
+    for (char c : placement) {
+        if (c == '/') {
+            --rank;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            const char* symbols = "pnbrqk";
+            const char* found = std::strchr(symbols, std::tolower(c));
+            if (!found || rank < 0 || file > 7) return false;
+            int color = std::isupper(c) ? WHITE : BLACK;
+            pos.pieces[color][found - symbols] |= 1ULL << (rank * 8 + file);
+            ++file;
+        }
+    }
+    if (__builtin_popcountll(pos.pieces[WHITE][KING]) != 1 || __builtin_popcountll(pos.pieces[BLACK][KING]) != 1) return false;
+
+    pos.whiteToMove = (side != "b");
+
+    pos.castlingRights = 0;
+    for (char c : castling) {
+        if (c == 'K') pos.castlingRights |= WHITE_KINGSIDE;
+        else if (c == 'Q') pos.castlingRights |= WHITE_QUEENSIDE;
+        else if (c == 'k') pos.castlingRights |= BLACK_KINGSIDE;
+        else if (c == 'q') pos.castlingRights |= BLACK_QUEENSIDE;
+    }
+
+    pos.enPassantTarget = 0;
+    if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' && enPassant[1] >= '1' && enPassant[1] <= '8') {
+        pos.enPassantTarget = 1ULL << ((enPassant[1] - '1') * 8 + (enPassant[0] - 'a'));
+    }
+
+    // The halfmove clock is optional; a FEN without one starts it at zero
+    int halfmoveClock = 0;
+    if (!(stream >> halfmoveClock) || halfmoveClock < 0) halfmoveClock = 0;
+    pos.halfmoveClock = halfmoveClock;
+    pos.historyLength = 0;
+
+    updateOccupancy(pos);
+    pos.key = computeKey(pos);
+    return true;
 }
 
 // Print the board in a human-readable format
-void printBoardForPlayers() {
+void printBoardForPlayers(const Position& pos) {
     std::cout << "\nCurrent Board:\n";
     std::cout << "  a b c d e f g h\n +----------------+\n";
     for (int rank = 7; rank >= 0; --rank) {
         std::cout << rank + 1 << "| ";
         for (int file = 0; file < 8; ++file) {
             int square = rank * 8 + file;
-            uint64_t mask = 1ULL << square;
-            if (whitePawns & mask) std::cout << "P ";
-            else if (whiteKnights & mask) std::cout << "N ";
-            else if (whiteBishops & mask) std::cout << "B ";
-            else if (whiteRooks & mask) std::cout << "R ";
-            else if (whiteQueens & mask) std::cout << "Q ";
-            else if (whiteKing & mask) std::cout << "K ";
-            else if (blackPawns & mask) std::cout << "p ";
-            else if (blackKnights & mask) std::cout << "n ";
-            else if (blackBishops & mask) std::cout << "b ";
-            else if (blackRooks & mask) std::cout << "r ";
-            else if (blackQueens & mask) std::cout << "q ";
-            else if (blackKing & mask) std::cout << "k ";
-            else std::cout << ". ";
+            std::cout << "PNBRQKpnbrqk."[pos.mailbox[square]] << ' ';
         }
         std::cout << "|\n";
     }
@@ -129,299 +250,536 @@ void printBoardForPlayers() {
 }
 
 // Check if a square is attacked by any enemy piece
-bool isSquareAttacked(uint64_t square, bool byWhite) {
-    uint64_t enemyPawns = byWhite ? whitePawns : blackPawns;
-    uint64_t enemyKnights = byWhite ? whiteKnights : blackKnights;
-    uint64_t enemyBishops = byWhite ? whiteBishops : blackBishops;
-    uint64_t enemyRooks = byWhite ? whiteRooks : blackRooks;
-    uint64_t enemyQueens = byWhite ? whiteQueens : blackQueens;
-    uint64_t enemyKing = byWhite ? whiteKing : blackKing;
-    uint64_t enemyPieces = byWhite ? whitePieces : blackPieces;
-
-    // Pawn attacks
-    if (byWhite) {
-        if (((enemyPawns << 7) & ~FILE_H & square) || ((enemyPawns << 9) & ~FILE_A & square)) {
-            return true; // White Pawn attacking left or right
-        }
-    } else {
-        if (((enemyPawns >> 7) & ~FILE_A & square) || ((enemyPawns >> 9) & ~FILE_H & square)) {
-            return true; // Black Pawn attacking left or right
-        }
-    }
+bool isSquareAttacked(const Position& pos, uint64_t square, bool byWhite) {
+    const uint64_t* enemy = pos.pieces[byWhite ? WHITE : BLACK];
+    int sq = __builtin_ctzll(square);
 
-    // Knight attacks
-    uint64_t knightAttacks = ((square << 17) & ~FILE_A) | ((square << 15) & ~FILE_H) |
-                             ((square >> 17) & ~FILE_H) | ((square >> 15) & ~FILE_A) |
-                             ((square << 10) & ~(FILE_A | FILE_B)) | ((square >> 10) & ~(FILE_H | FILE_G)) |
-                             ((square << 6) & ~(FILE_H | FILE_G)) | ((square >> 6) & ~(FILE_A | FILE_B));
-    if (enemyKnights & knightAttacks) return true;
+    // Pawn attacks: a pawn attacks this square if it sits where an opposite-coloured pawn on it would attack
+    if (PAWN_ATTACKS[byWhite ? BLACK : WHITE][sq] & enemy[PAWN]) return true;
 
-    // Sliding piece attacks (bishops, rooks, queens)
-    uint64_t bishopAttacks = slideMove(square, 7, enemyPieces) | slideMove(square, 9, enemyPieces) |
-                             slideMove(square, -7, enemyPieces) | slideMove(square, -9, enemyPieces);
-    if (enemyBishops & bishopAttacks || enemyQueens & bishopAttacks) return true;
+    // Knight attacks
+    if (KNIGHT_ATTACKS[sq] & enemy[KNIGHT]) return true;
 
-    uint64_t rookAttacks = slideMove(square, 1, enemyPieces) | slideMove(square, -1, enemyPieces) |
-                           slideMove(square, 8, enemyPieces) | slideMove(square, -8, enemyPieces);
-    if (enemyRooks & rookAttacks || enemyQueens & rookAttacks) return true;
+    // Sliding piece attacks (bishops, rooks, queens), blocked by pieces of either colour
+    if (bishopAttacks(sq, pos.allPieces) & (enemy[BISHOP] | enemy[QUEEN])) return true;
+    if (rookAttacks(sq, pos.allPieces) & (enemy[ROOK] | enemy[QUEEN])) return true;
 
     // King attacks
-    uint64_t kingAttacks = (square << 8) | (square >> 8) |
-                           ((square << 1) & ~FILE_A) | ((square >> 1) & ~FILE_H) |
-                           ((square << 9) & ~FILE_A) | ((square >> 9) & ~FILE_H) |
-                           ((square << 7) & ~FILE_H) | ((square >> 7) & ~FILE_A);
-    if (enemyKing & kingAttacks) return true;
+    if (KING_ATTACKS[sq] & enemy[KING]) return true;
 
     return false;
 }
 
-// Convert a square in bitboard format to chess notation (e.g., 1ULL << 0 -> "a1")
-std::string squareToNotation(uint64_t square) {
-    if (square == 0) {
-        return "null"; // Handle case where square is invalid
-    }
-
-    // Get the index of the square (position of the least significant bit)
-    int index = __builtin_ctzll(square); // Count trailing zeros (find the bit position)
+// Check if the side to move is in check
+bool isInCheck(const Position& pos) {
+    int us = pos.whiteToMove ? WHITE : BLACK;
+    return isSquareAttacked(pos, pos.pieces[us][KING], !pos.whiteToMove);
+}
 
-    // Convert the index into file (column) and rank (row)
-    char file = 'a' + (index % 8);      // Files are a-h (0-7 mod 8)
-    char rank = '1' + (index / 8);      // Ranks are 1-8 (0-7 div 8)
+// All pieces of either colour attacking a square, given an occupancy
+uint64_t attackersTo(const Position& pos, int sq, uint64_t occupied) {
+    const uint64_t (*p)[6] = pos.pieces;
+    return (PAWN_ATTACKS[BLACK][sq] & p[WHITE][PAWN]) |
+           (PAWN_ATTACKS[WHITE][sq] & p[BLACK][PAWN]) |
+           (KNIGHT_ATTACKS[sq] & (p[WHITE][KNIGHT] | p[BLACK][KNIGHT])) |
+           (bishopAttacks(sq, occupied) & (p[WHITE][BISHOP] | p[BLACK][BISHOP] | p[WHITE][QUEEN] | p[BLACK][QUEEN])) |
+           (rookAttacks(sq, occupied) & (p[WHITE][ROOK] | p[BLACK][ROOK] | p[WHITE][QUEEN] | p[BLACK][QUEEN])) |
+           (KING_ATTACKS[sq] & (p[WHITE][KING] | p[BLACK][KING]));
+}
 
-    return std::string(1, file) + std::string(1, rank); // Combine file and rank into a single string
+// Work out checkers, the check mask and pinned pieces for the side to move
+LegalityInfo computeLegalityInfo(const Position& pos) {
+    int us = pos.whiteToMove ? WHITE : BLACK;
+    int them = us ^ 1;
+    LegalityInfo info;
+    info.kingSquare = __builtin_ctzll(pos.pieces[us][KING]);
+    info.checkers = attackersTo(pos, info.kingSquare, pos.allPieces) & pos.occupancy[them];
+    info.pinned = 0;
+
+    if (!info.checkers) info.checkMask = ~0ULL;
+    else if (info.checkers & (info.checkers - 1)) info.checkMask = 0; // Double check: only the king can move
+    else info.checkMask = info.checkers | betweenSquares[info.kingSquare][__builtin_ctzll(info.checkers)];
+
+    // Enemy sliders lined up with our king, with exactly one of our pieces in between, pin that piece
+    uint64_t snipers = (rookAttacks(info.kingSquare, 0) & (pos.pieces[them][ROOK] | pos.pieces[them][QUEEN])) |
+                       (bishopAttacks(info.kingSquare, 0) & (pos.pieces[them][BISHOP] | pos.pieces[them][QUEEN]));
+    while (snipers) {
+        int sniper = __builtin_ctzll(snipers);
+        snipers &= snipers - 1;
+        uint64_t blockers = betweenSquares[info.kingSquare][sniper] & pos.allPieces;
+        if (blockers && !(blockers & (blockers - 1)) && (blockers & pos.occupancy[us])) {
+            info.pinned |= blockers;
+        }
+    }
+    return info;
 }
 
-// Check if a move is legal
-bool isMoveLegal(uint64_t fromSquare, uint64_t toSquare, bool isWhite) {
-    uint64_t savedWhitePieces = whitePieces;
-    uint64_t savedBlackPieces = blackPieces;
-    uint64_t savedAllPieces = allPieces;
-    uint64_t king = isWhite ? whiteKing : blackKing;
+// Destination squares a non-king piece may legally move to
+static inline uint64_t legalTargets(const LegalityInfo& info, int from) {
+    uint64_t targets = info.checkMask;
+    if (info.pinned & (1ULL << from)) targets &= lineThrough[info.kingSquare][from];
+    return targets;
+}
 
-    // Temporarily make the move
-    if (isWhite) {
-        whitePieces ^= fromSquare | toSquare;
-        allPieces = whitePieces | blackPieces;
-    } else {
-        blackPieces ^= fromSquare | toSquare;
-        allPieces = whitePieces | blackPieces;
+// Append one move per target square
+static void addMoves(int from, uint64_t targets, MoveList& moves) {
+    while (targets) {
+        moves.add(encodeMove(from, __builtin_ctzll(targets)));
+        targets &= targets - 1;
     }
+}
 
-    // Check if the king is in check
-    bool kingInCheck = isSquareAttacked(king, !isWhite);
-    if (kingInCheck) {
-        std::cout << "Move from " << squareToNotation(fromSquare) << " to " << squareToNotation(toSquare)
-                  << " leaves king in check. Illegal.\n";
+// Append pawn moves from one square, expanding promotions
+static void addPawnMoves(int from, uint64_t targets, MoveList& moves) {
+    while (targets) {
+        int to = __builtin_ctzll(targets);
+        targets &= targets - 1;
+        if ((1ULL << to) & (RANK_1 | RANK_8)) {
+            moves.add(encodeMove(from, to, MOVE_PROMOTION, QUEEN));
+            moves.add(encodeMove(from, to, MOVE_PROMOTION, ROOK));
+            moves.add(encodeMove(from, to, MOVE_PROMOTION, BISHOP));
+            moves.add(encodeMove(from, to, MOVE_PROMOTION, KNIGHT));
+        } else {
+            moves.add(encodeMove(from, to));
+        }
     }
-
-    // Restore original positions
-    whitePieces = savedWhitePieces;
-    blackPieces = savedBlackPieces;
-    allPieces = savedAllPieces;
-
-    return !kingInCheck;
 }
 
-// Generate pawn moves
-std::vector<uint64_t> generatePawnMoves(uint64_t pawns, bool isWhite) {
-    std::vector<uint64_t> moves;
-    uint64_t singleStep, doubleStep, attacksLeft, attacksRight;
-
-    if (isWhite) {
-        singleStep = (pawns << 8) & ~allPieces;
-        doubleStep = ((pawns & RANK_2) << 16) & ~allPieces & ~(allPieces << 8);
-        attacksLeft = (pawns << 7) & blackPieces & ~FILE_H;
-        attacksRight = (pawns << 9) & blackPieces & ~FILE_A;
-    } else {
-        singleStep = (pawns >> 8) & ~allPieces;
-        doubleStep = ((pawns & RANK_7) >> 16) & ~allPieces & ~(allPieces >> 8);
-        attacksLeft = (pawns >> 7) & whitePieces & ~FILE_A;
-        attacksRight = (pawns >> 9) & whitePieces & ~FILE_H;
+// Generate legal pawn pushes, captures and promotions
+void generatePawnMoves(const Position& pos, const LegalityInfo& info, MoveList& moves) {
+    bool isWhite = pos.whiteToMove;
+    uint64_t pawns = pos.pieces[isWhite ? WHITE : BLACK][PAWN];
+    uint64_t enemyPieces = pos.occupancy[isWhite ? BLACK : WHITE];
+    uint64_t startRank = isWhite ? RANK_2 : RANK_7;
+    int forward = isWhite ? 8 : -8;
+
+    while (pawns) {
+        int from = __builtin_ctzll(pawns);
+        pawns &= pawns - 1;
+
+        uint64_t targets = PAWN_ATTACKS[isWhite ? WHITE : BLACK][from] & enemyPieces;
+        uint64_t singleStep = 1ULL << (from + forward);
+        if (!(singleStep & pos.allPieces)) {
+            targets |= singleStep;
+            uint64_t doubleStep = isWhite ? singleStep << 8 : singleStep >> 8;
+            if (((1ULL << from) & startRank) && !(doubleStep & pos.allPieces)) targets |= doubleStep;
+        }
+        addPawnMoves(from, targets & legalTargets(info, from), moves);
     }
-
-    if (singleStep) moves.push_back(singleStep);
-    if (doubleStep) moves.push_back(doubleStep);
-    if (attacksLeft) moves.push_back(attacksLeft);
-    if (attacksRight) moves.push_back(attacksRight);
-
-    return moves;
 }
 
-// Generate knight moves
-std::vector<uint64_t> generateKnightMoves(uint64_t knights, bool isWhite) {
-    std::vector<uint64_t> moves;
-    uint64_t targets = isWhite ? blackPieces : whitePieces;
-    uint64_t potentialMoves;
+// Generate legal knight moves (a pinned knight can never move)
+void generateKnightMoves(const Position& pos, const LegalityInfo& info, MoveList& moves) {
+    int us = pos.whiteToMove ? WHITE : BLACK;
+    uint64_t knights = pos.pieces[us][KNIGHT] & ~info.pinned;
 
     while (knights) {
-        uint64_t knight = knights & -knights;
+        int knight = __builtin_ctzll(knights);
         knights &= knights - 1;
-
-        potentialMoves = ((knight << 17) & ~FILE_A) | ((knight << 15) & ~FILE_H) |
-                         ((knight << 10) & ~(FILE_A | FILE_B)) | ((knight << 6) & ~(FILE_G | FILE_H)) |
-                         ((knight >> 17) & ~FILE_H) | ((knight >> 15) & ~FILE_A) |
-                         ((knight >> 10) & ~(FILE_G | FILE_H)) | ((knight >> 6) & ~(FILE_A | FILE_B));
-
-        moves.push_back(potentialMoves & ~targets);
+        addMoves(knight, KNIGHT_ATTACKS[knight] & ~pos.occupancy[us] & info.checkMask, moves);
     }
-    return moves;
 }
 
-// Generate bishop moves (diagonals)
-std::vector<uint64_t> generateBishopMoves(uint64_t bishops, bool isWhite) {
-    std::vector<uint64_t> moves;
-    uint64_t targets = isWhite ? blackPieces : whitePieces;
+// Generate legal bishop moves (diagonals)
+void generateBishopMoves(const Position& pos, const LegalityInfo& info, MoveList& moves) {
+    int us = pos.whiteToMove ? WHITE : BLACK;
+    uint64_t bishops = pos.pieces[us][BISHOP];
 
     while (bishops) {
-        uint64_t bishop = bishops & -bishops;
+        int bishop = __builtin_ctzll(bishops);
         bishops &= bishops - 1;
-        uint64_t diagonalMoves = slideMove(bishop, 9, allPieces) | slideMove(bishop, 7, allPieces) |
-                                 slideMove(bishop, -9, allPieces) | slideMove(bishop, -7, allPieces);
-        moves.push_back(diagonalMoves & ~targets);
+        addMoves(bishop, bishopAttacks(bishop, pos.allPieces) & ~pos.occupancy[us] & legalTargets(info, bishop), moves);
     }
-    return moves;
 }
 
-// Generate rook moves (straight lines)
-std::vector<uint64_t> generateRookMoves(uint64_t rooks, bool isWhite) {
-    std::vector<uint64_t> moves;
-    uint64_t targets = isWhite ? blackPieces : whitePieces;
+// Generate legal rook moves (straight lines)
+void generateRookMoves(const Position& pos, const LegalityInfo& info, MoveList& moves) {
+    int us = pos.whiteToMove ? WHITE : BLACK;
+    uint64_t rooks = pos.pieces[us][ROOK];
 
     while (rooks) {
-        uint64_t rook = rooks & -rooks;
+        int rook = __builtin_ctzll(rooks);
         rooks &= rooks - 1;
-        uint64_t straightMoves = slideMove(rook, 8, allPieces) | slideMove(rook, -8, allPieces) |
-                                 slideMove(rook, 1, allPieces) | slideMove(rook, -1, allPieces);
-        moves.push_back(straightMoves & ~targets);
+        addMoves(rook, rookAttacks(rook, pos.allPieces) & ~pos.occupancy[us] & legalTargets(info, rook), moves);
     }
-    return moves;
 }
 
-// Generate queen moves by combining rook and bishop moves
-std::vector<uint64_t> generateQueenMoves(uint64_t queens, bool isWhite) {
-    std::vector<uint64_t> moves;
-    uint64_t targets = isWhite ? blackPieces : whitePieces;
+// Generate legal queen moves by combining rook and bishop moves
+void generateQueenMoves(const Position& pos, const LegalityInfo& info, MoveList& moves) {
+    int us = pos.whiteToMove ? WHITE : BLACK;
+    uint64_t queens = pos.pieces[us][QUEEN];
 
     while (queens) {
-        uint64_t queen = queens & -queens;
+        int queen = __builtin_ctzll(queens);
         queens &= queens - 1;
-        uint64_t queenMoves = slideMove(queen, 8, allPieces) | slideMove(queen, -8, allPieces) |
-                              slideMove(queen, 1, allPieces) | slideMove(queen, -1, allPieces) |
-                              slideMove(queen, 9, allPieces) | slideMove(queen, 7, allPieces) |
-                              slideMove(queen, -9, allPieces) | slideMove(queen, -7, allPieces);
-        moves.push_back(queenMoves & ~targets);
+        addMoves(queen, queenAttacks(queen, pos.allPieces) & ~pos.occupancy[us] & legalTargets(info, queen), moves);
     }
-    return moves;
 }
 
-// Generate king moves
-std::vector<uint64_t> generateKingMoves(uint64_t king, bool isWhite) {
-    std::vector<uint64_t> moves;
-    uint64_t targets = isWhite ? blackPieces : whitePieces;
-
-    uint64_t kingMoves = ((king << 8) | (king >> 8) | ((king & ~FILE_H) << 1) | ((king & ~FILE_A) >> 1) |
-                          ((king & ~FILE_H) << 9) | ((king & ~FILE_A) << 7) |
-                          ((king & ~FILE_H) >> 7) | ((king & ~FILE_A) >> 9));
-    moves.push_back(kingMoves & ~targets);
+// Generate legal king moves, including castling
+void generateKingMoves(const Position& pos, const LegalityInfo& info, MoveList& moves) {
+    bool isWhite = pos.whiteToMove;
+    int us = isWhite ? WHITE : BLACK;
+    int them = us ^ 1;
+    int kingSq = info.kingSquare;
+
+    // The king must not step onto an attacked square; look through the king itself so it
+    // cannot hide behind its own square along a checking ray
+    uint64_t occupied = pos.allPieces ^ (1ULL << kingSq);
+    uint64_t targets = KING_ATTACKS[kingSq] & ~pos.occupancy[us];
+    while (targets) {
+        int to = __builtin_ctzll(targets);
+        targets &= targets - 1;
+        if (!(attackersTo(pos, to, occupied) & pos.occupancy[them])) moves.add(encodeMove(kingSq, to));
+    }
 
-    return moves;
+    if (info.checkers) return;
+    if (canCastleKingside(pos, isWhite)) moves.add(encodeMove(kingSq, kingSq + 2, MOVE_CASTLING));
+    if (canCastleQueenside(pos, isWhite)) moves.add(encodeMove(kingSq, kingSq - 2, MOVE_CASTLING));
 }
 
 // Check if the king can castle kingside
-bool canCastleKingside(bool isWhite) {
-    uint64_t kingPosition = isWhite ? whiteKing : blackKing;
-    uint64_t rookPosition = isWhite ? whiteRooks : blackRooks;
+bool canCastleKingside(const Position& pos, bool isWhite) {
+    uint64_t kingPosition = pos.pieces[isWhite ? WHITE : BLACK][KING];
     uint64_t kingsideMask = isWhite ? 0x60ULL : 0x6000000000000000ULL;
 
-    bool kingsideAvailable = (isWhite ? whiteKingsideCastle : blackKingsideCastle) &&
-                             !(allPieces & kingsideMask) &&
-                             !isSquareAttacked(kingPosition, !isWhite) &&
-                             !isSquareAttacked(kingPosition << 1, !isWhite) &&
-                             !isSquareAttacked(kingPosition << 2, !isWhite);
+    bool kingsideAvailable = (pos.castlingRights & (isWhite ? WHITE_KINGSIDE : BLACK_KINGSIDE)) &&
+                             !(pos.allPieces & kingsideMask) &&
+                             !isSquareAttacked(pos, kingPosition, !isWhite) &&
+                             !isSquareAttacked(pos, kingPosition << 1, !isWhite) &&
+                             !isSquareAttacked(pos, kingPosition << 2, !isWhite);
     return kingsideAvailable;
 }
 
 // Check if the king can castle queenside
-bool canCastleQueenside(bool isWhite) {
-    uint64_t kingPosition = isWhite ? whiteKing : blackKing;
-    uint64_t rookPosition = isWhite ? whiteRooks : blackRooks;
+bool canCastleQueenside(const Position& pos, bool isWhite) {
+    uint64_t kingPosition = pos.pieces[isWhite ? WHITE : BLACK][KING];
     uint64_t queensideMask = isWhite ? 0xEULL : 0xE00000000000000ULL;
 
-    bool queensideAvailable = (isWhite ? whiteQueensideCastle : blackQueensideCastle) &&
-                              !(allPieces & queensideMask) &&
-                              !isSquareAttacked(kingPosition, !isWhite) &&
-                              !isSquareAttacked(kingPosition >> 1, !isWhite) &&
-                              !isSquareAttacked(kingPosition >> 2, !isWhite);
+    bool queensideAvailable = (pos.castlingRights & (isWhite ? WHITE_QUEENSIDE : BLACK_QUEENSIDE)) &&
+                              !(pos.allPieces & queensideMask) &&
+                              !isSquareAttacked(pos, kingPosition, !isWhite) &&
+                              !isSquareAttacked(pos, kingPosition >> 1, !isWhite) &&
+                              !isSquareAttacked(pos, kingPosition >> 2, !isWhite);
     return queensideAvailable;
 }
 
-// Generate en passant moves
-std::vector<uint64_t> generateEnPassantMoves(uint64_t pawns, bool isWhite) {
-    std::vector<uint64_t> moves;
-    if (enPassantTarget == 0) return moves;
-
-    uint64_t enPassantLeft = isWhite ? (pawns << 7) & ~FILE_H & enPassantTarget
-                                      : (pawns >> 7) & ~FILE_A & enPassantTarget;
-    uint64_t enPassantRight = isWhite ? (pawns << 9) & ~FILE_A & enPassantTarget
-                                       : (pawns >> 9) & ~FILE_H & enPassantTarget;
-
-    if (enPassantLeft) moves.push_back(enPassantLeft);
-    if (enPassantRight) moves.push_back(enPassantRight);
-    return moves;
-}
-
-// Handle pawn promotion
-void handlePawnPromotion(uint64_t toBit, uint64_t isWhiteTurn) {
-    if (isWhiteTurn && (toBit & RANK_8)) {
-        whitePawns ^= toBit;
-        whiteQueens |= toBit;
-    } else if (!isWhiteTurn && (toBit & RANK_1)) {
-        blackPawns ^= toBit;
-        blackQueens |= toBit;
-    }
-    whitePieces = whitePawns | whiteKnights | whiteBishops | whiteRooks | whiteQueens | whiteKing;
-    blackPieces = blackPawns | blackKnights | blackBishops | blackRooks | blackQueens | blackKing;
-    allPieces = whitePieces | blackPieces;
-}
-
-// Check if the current position is checkmate or stalemate
-bool isCheckmateOrStalemate(bool isWhiteTurn) {
-    uint64_t king = isWhiteTurn ? whiteKing : blackKing;
-    bool kingInCheck = isSquareAttacked(king, !isWhiteTurn);
-
-    // Iterate over all pieces of the current player and try all possible moves
-    uint64_t pieces = isWhiteTurn ? whitePieces : blackPieces;
-    while (pieces) {
-        uint64_t piece = pieces & -pieces; // Isolate the least significant bit (current piece)
-        pieces &= pieces - 1;              // Remove the isolated piece from the set
-
-        // Generate all legal moves for this piece
-        std::vector<uint64_t> legalMoves;
-        if (isWhiteTurn) {
-            if (whitePawns & piece) legalMoves = generatePawnMoves(piece, true);
-            else if (whiteKnights & piece) legalMoves = generateKnightMoves(piece, true);
-            else if (whiteBishops & piece) legalMoves = generateBishopMoves(piece, true);
-            else if (whiteRooks & piece) legalMoves = generateRookMoves(piece, true);
-            else if (whiteQueens & piece) legalMoves = generateQueenMoves(piece, true);
-            else if (whiteKing & piece) legalMoves = generateKingMoves(piece, true);
-        } else {
-            if (blackPawns & piece) legalMoves = generatePawnMoves(piece, false);
-            else if (blackKnights & piece) legalMoves = generateKnightMoves(piece, false);
-            else if (blackBishops & piece) legalMoves = generateBishopMoves(piece, false);
-            else if (blackRooks & piece) legalMoves = generateRookMoves(piece, false);
-            else if (blackQueens & piece) legalMoves = generateQueenMoves(piece, false);
-            else if (blackKing & piece) legalMoves = generateKingMoves(piece, false);
+// Generate legal en passant captures
+void generateEnPassantMoves(const Position& pos, const LegalityInfo& info, MoveList& moves) {
+    if (pos.enPassantTarget == 0) return;
+
+    bool isWhite = pos.whiteToMove;
+    int us = isWhite ? WHITE : BLACK;
+    int them = us ^ 1;
+    int target = __builtin_ctzll(pos.enPassantTarget);
+    int capturedSq = isWhite ? target - 8 : target + 8;
+
+    // When in check, the capture must either take the checking pawn or block the check
+    if (!(info.checkMask & (pos.enPassantTarget | (1ULL << capturedSq)))) return;
+
+    // Pawns that could capture onto the target are those a pawn of the other colour there would attack
+    uint64_t capturers = PAWN_ATTACKS[them][target] & pos.pieces[us][PAWN];
+    while (capturers) {
+        int from = __builtin_ctzll(capturers);
+        capturers &= capturers - 1;
+
+        // Two pawns leave the board at once, so rerun the slider test on the resulting occupancy
+        uint64_t occupied = (pos.allPieces ^ (1ULL << from) ^ (1ULL << capturedSq)) | pos.enPassantTarget;
+        uint64_t sliders = (bishopAttacks(info.kingSquare, occupied) & (pos.pieces[them][BISHOP] | pos.pieces[them][QUEEN])) |
+                           (rookAttacks(info.kingSquare, occupied) & (pos.pieces[them][ROOK] | pos.pieces[them][QUEEN]));
+        if (!sliders) moves.add(encodeMove(from, target, MOVE_EN_PASSANT));
+    }
+}
+
+// Generate every legal move for the side to move
+void generateLegalMoves(const Position& pos, MoveList& moves) {
+    LegalityInfo info = computeLegalityInfo(pos);
+
+    // In double check only king moves can help
+    if (info.checkMask) {
+        generatePawnMoves(pos, info, moves);
+        generateEnPassantMoves(pos, info, moves);
+        generateKnightMoves(pos, info, moves);
+        generateBishopMoves(pos, info, moves);
+        generateRookMoves(pos, info, moves);
+        generateQueenMoves(pos, info, moves);
+    }
+    generateKingMoves(pos, info, moves);
+}
+
+// Generate only legal captures and promotions (for quiescence search)
+void generateCaptures(const Position& pos, MoveList& moves) {
+    LegalityInfo info = computeLegalityInfo(pos);
+    bool isWhite = pos.whiteToMove;
+    int us = isWhite ? WHITE : BLACK;
+    int them = us ^ 1;
+    uint64_t enemyPieces = pos.occupancy[them];
+
+    if (info.checkMask) {
+        generateEnPassantMoves(pos, info, moves);
+
+        // Pawn captures, plus pushes onto the last rank
+        uint64_t pawns = pos.pieces[us][PAWN];
+        uint64_t promotionRank = isWhite ? RANK_8 : RANK_1;
+        int forward = isWhite ? 8 : -8;
+        while (pawns) {
+            int from = __builtin_ctzll(pawns);
+            pawns &= pawns - 1;
+
+            uint64_t targets = PAWN_ATTACKS[us][from] & enemyPieces;
+            uint64_t singleStep = 1ULL << (from + forward);
+            if ((singleStep & promotionRank) && !(singleStep & pos.allPieces)) targets |= singleStep;
+            addPawnMoves(from, targets & legalTargets(info, from), moves);
         }
 
-        // Check each legal move to see if it leaves the king safe
-        for (uint64_t move : legalMoves) {
-            if (isMoveLegal(piece, move, isWhiteTurn)) {
-                // If at least one legal move exists, it's not checkmate or stalemate
-                return false;
+        // Other pieces may only land on enemy pieces
+        LegalityInfo captureInfo = info;
+        captureInfo.checkMask &= enemyPieces;
+        generateKnightMoves(pos, captureInfo, moves);
+        generateBishopMoves(pos, captureInfo, moves);
+        generateRookMoves(pos, captureInfo, moves);
+        generateQueenMoves(pos, captureInfo, moves);
+    }
+
+    uint64_t occupied = pos.allPieces ^ (1ULL << info.kingSquare);
+    uint64_t targets = KING_ATTACKS[info.kingSquare] & enemyPieces;
+    while (targets) {
+        int to = __builtin_ctzll(targets);
+        targets &= targets - 1;
+        if (!(attackersTo(pos, to, occupied) & pos.occupancy[them])) moves.add(encodeMove(info.kingSquare, to));
+    }
+}
+
+// Check a move from outside the generator (transposition table, killer slot) against the legal
+// moves of the piece type standing on its from-square
+bool isLegalMove(const Position& pos, Move move) {
+    int us = pos.whiteToMove ? WHITE : BLACK;
+    int from = moveFrom(move);
+    if (!(pos.occupancy[us] & (1ULL << from))) return false;
+
+    LegalityInfo info = computeLegalityInfo(pos);
+    MoveList moves;
+    switch (pos.pieceTypeAt(from)) {
+        case PAWN:
+            if (info.checkMask) {
+                generatePawnMoves(pos, info, moves);
+                generateEnPassantMoves(pos, info, moves);
             }
-        }
+            break;
+        case KNIGHT: if (info.checkMask) generateKnightMoves(pos, info, moves); break;
+        case BISHOP: if (info.checkMask) generateBishopMoves(pos, info, moves); break;
+        case ROOK: if (info.checkMask) generateRookMoves(pos, info, moves); break;
+        case QUEEN: if (info.checkMask) generateQueenMoves(pos, info, moves); break;
+        case KING: generateKingMoves(pos, info, moves); break;
+    }
+    return std::find(moves.begin(), moves.end(), move) != moves.end();
+}
+
+// Check if a move takes an enemy piece
+bool isCapture(const Position& pos, Move move) {
+    return (pos.occupancy[pos.whiteToMove ? BLACK : WHITE] & (1ULL << moveTo(move))) || moveFlag(move) == MOVE_EN_PASSANT;
+}
+
+// Apply a generated move to the board (no legality checks), returning what is needed to undo it
+UndoInfo makeMove(Position& pos, Move move) {
+    int us = pos.whiteToMove ? WHITE : BLACK;
+    int them = us ^ 1;
+    int from = moveFrom(move);
+    int to = moveTo(move);
+    int flag = moveFlag(move);
+    int piece = pos.pieceTypeAt(from);
+
+    UndoInfo undo = {-1, pos.castlingRights, pos.enPassantTarget, pos.key, pos.halfmoveClock};
+
+    pos.keyHistory[pos.historyLength++ % KEY_HISTORY_SIZE] = pos.key;
+    ++pos.halfmoveClock;
+
+    // Take the old side, castling and en passant state out of the key; piece moves update it as they happen
+    pos.key ^= zobristSide ^ zobristCastling[pos.castlingRights];
+    if (pos.enPassantTarget) pos.key ^= zobristEnPassant[__builtin_ctzll(pos.enPassantTarget) % 8];
+
+    // Remove a captured piece
+    if (flag == MOVE_EN_PASSANT) {
+        removePiece(pos, them, PAWN, pos.whiteToMove ? to - 8 : to + 8);
+    } else if (pos.occupancy[them] & (1ULL << to)) {
+        undo.capturedPiece = pos.pieceTypeAt(to);
+        removePiece(pos, them, undo.capturedPiece, to);
+    }
+
+    // Captures and pawn moves cannot be undone, so no earlier position can come back
+    if (piece == PAWN || undo.capturedPiece >= 0) pos.halfmoveClock = 0;
+
+    // Move the piece, replacing a promoting pawn with the new piece
+    if (flag == MOVE_PROMOTION) {
+        removePiece(pos, us, PAWN, from);
+        addPiece(pos, us, movePromotion(move), to);
+    } else {
+        movePiece(pos, us, piece, from, to);
+    }
+
+    // Castling also moves the rook
+    if (flag == MOVE_CASTLING) {
+        if (to > from) movePiece(pos, us, ROOK, to + 1, to - 1);
+        else movePiece(pos, us, ROOK, to - 2, to + 1);
+    }
+
+    // Moving the king or a rook, or capturing a rook, loses castling rights
+    pos.castlingRights &= castlingMask[from] & castlingMask[to];
+
+    // A double pawn push leaves an en passant target behind it
+    pos.enPassantTarget = 0;
+    if (piece == PAWN && (to - from == 16 || from - to == 16)) {
+        pos.enPassantTarget = 1ULL << ((from + to) / 2);
+        pos.key ^= zobristEnPassant[from % 8];
+    }
+    pos.key ^= zobristCastling[pos.castlingRights];
+
+    // Every feature of the mover's half depends on where its king stands
+    if (nnueEnabled && piece == KING) nnueRefresh(pos, us);
+
+    pos.whiteToMove = !pos.whiteToMove;
+
+#ifdef ZOBRIST_DEBUG
+    verifyKey(pos, "makeMove");
+#endif
+    return undo;
+}
+
+// Take back a move made by makeMove, using only its undo record
+void unmakeMove(Position& pos, Move move, const UndoInfo& undo) {
+    pos.whiteToMove = !pos.whiteToMove;
+    pos.castlingRights = undo.castlingRights;
+    pos.enPassantTarget = undo.enPassantTarget;
+    pos.halfmoveClock = undo.halfmoveClock;
+    --pos.historyLength;
+
+    int us = pos.whiteToMove ? WHITE : BLACK;
+    int them = us ^ 1;
+    int from = moveFrom(move);
+    int to = moveTo(move);
+    int flag = moveFlag(move);
+
+    if (flag == MOVE_CASTLING) {
+        if (to > from) movePiece(pos, us, ROOK, to - 1, to + 1);
+        else movePiece(pos, us, ROOK, to + 1, to - 2);
+    }
+
+    if (flag == MOVE_PROMOTION) {
+        removePiece(pos, us, movePromotion(move), to);
+        addPiece(pos, us, PAWN, from);
+    } else {
+        movePiece(pos, us, pos.pieceTypeAt(to), to, from);
+    }
+
+    if (flag == MOVE_EN_PASSANT) {
+        addPiece(pos, them, PAWN, pos.whiteToMove ? to - 8 : to + 8);
+    } else if (undo.capturedPiece >= 0) {
+        addPiece(pos, them, undo.capturedPiece, to);
     }
 
-    // If no legal moves and king is in check, it's checkmate; otherwise, stalemate
-    return kingInCheck;
+    // A king move back changes its half just as much
+    if (nnueEnabled && pos.pieceTypeAt(from) == KING) nnueRefresh(pos, us);
+
+    // The piece updates cancel out, but side, castling and en passant keys were not undone
+    pos.key = undo.key;
+
+#ifdef ZOBRIST_DEBUG
+    verifyKey(pos, "unmakeMove");
+#endif
+}
+
+// Pass the turn without moving (for null move pruning). Positions before a null move are not
+// real repetitions of the ones after it, so the halfmove clock restarts.
+UndoInfo makeNullMove(Position& pos) {
+    UndoInfo undo = {-1, pos.castlingRights, pos.enPassantTarget, pos.key, pos.halfmoveClock};
+    pos.keyHistory[pos.historyLength++ % KEY_HISTORY_SIZE] = pos.key;
+    pos.halfmoveClock = 0;
+    if (pos.enPassantTarget) pos.key ^= zobristEnPassant[__builtin_ctzll(pos.enPassantTarget) % 8];
+    pos.enPassantTarget = 0;
+    pos.key ^= zobristSide;
+    pos.whiteToMove = !pos.whiteToMove;
+
+#ifdef ZOBRIST_DEBUG
+    verifyKey(pos, "makeNullMove");
+#endif
+    return undo;
+}
+
+void unmakeNullMove(Position& pos, const UndoInfo& undo) {
+    pos.whiteToMove = !pos.whiteToMove;
+    pos.enPassantTarget = undo.enPassantTarget;
+    pos.key = undo.key;
+    pos.halfmoveClock = undo.halfmoveClock;
+    --pos.historyLength;
+
+#ifdef ZOBRIST_DEBUG
+    verifyKey(pos, "unmakeNullMove");
+#endif
+}
+
+// Validate and apply a move entered by a player (promotions default to a queen)
+bool makeMove(Position& pos, int fromSquare, int toSquare) {
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+
+    for (Move move : moves) {
+        if (moveFrom(move) != fromSquare || moveTo(move) != toSquare) continue;
+        if (moveFlag(move) == MOVE_PROMOTION && movePromotion(move) != QUEEN) continue;
+
+        makeMove(pos, move);
+        return true;
+    }
+    return false;
+}
+
+// Whether the side to move has at least one legal move. Generates one piece type at a time and
+// stops as soon as any of them has a move, so it is much cheaper than a full generation.
+bool hasLegalMove(const Position& pos) {
+    LegalityInfo info = computeLegalityInfo(pos);
+    MoveList moves;
+
+    generateKingMoves(pos, info, moves);
+    if (!moves.empty()) return true;
+    if (!info.checkMask) return false; // Double check: only the king could have moved
+
+    generatePawnMoves(pos, info, moves);
+    if (!moves.empty()) return true;
+    generateKnightMoves(pos, info, moves);
+    if (!moves.empty()) return true;
+    generateBishopMoves(pos, info, moves);
+    if (!moves.empty()) return true;
+    generateRookMoves(pos, info, moves);
+    if (!moves.empty()) return true;
+    generateQueenMoves(pos, info, moves);
+    if (!moves.empty()) return true;
+    generateEnPassantMoves(pos, info, moves);
+    return !moves.empty();
+}
+
+// How many times the current position occurred before. Only positions with the same side to
+// move since the last irreversible move (capture or pawn move) can match.
+int repetitionCount(const Position& pos) {
+    int count = 0;
+    int reach = std::min({pos.halfmoveClock, pos.historyLength, KEY_HISTORY_SIZE});
+    for (int back = 4; back <= reach; back += 2) {
+        if (pos.keyHistory[(pos.historyLength - back) % KEY_HISTORY_SIZE] == pos.key) ++count;
+    }
+    return count;
+}
+
+// Whether the current position occurred before; stops at the first match
+bool isRepetition(const Position& pos) {
+    int reach = std::min({pos.halfmoveClock, pos.historyLength, KEY_HISTORY_SIZE});
+    for (int back = 4; back <= reach; back += 2) {
+        if (pos.keyHistory[(pos.historyLength - back) % KEY_HISTORY_SIZE] == pos.key) return true;
+    }
+    return false;
+}
+
+// Draw by repetition or by the fifty-move rule. The search treats a single repetition as a draw:
+// if repeating was the best either side could do once, it will be again. A checkmate on the
+// hundredth ply still wins, so the side to move must not be mated for the fifty-move draw.
+bool isDraw(const Position& pos) {
+    if (isRepetition(pos)) return true;
+    return pos.halfmoveClock >= 100 && (!isInCheck(pos) || hasLegalMove(pos));
 }
@@ -3,65 +3,112 @@
 
 #include <vector>
 #include <cstdint>
-#include <stack>
-#include <unordered_map>
 #include <string>
 
-// Board state
-extern uint64_t whitePawns, whiteKnights, whiteBishops, whiteRooks, whiteQueens, whiteKing;
-extern uint64_t blackPawns, blackKnights, blackBishops, blackRooks, blackQueens, blackKing;
-extern uint64_t whitePieces, blackPieces, allPieces;
-extern bool whiteKingsideCastle, whiteQueensideCastle;
-extern bool blackKingsideCastle, blackQueensideCastle;
-extern uint64_t enPassantTarget;
+#include "move.h"
+#include "nnue.h"
+
+// Castling rights bits
+const int WHITE_KINGSIDE = 1;
+const int WHITE_QUEENSIDE = 2;
+const int BLACK_KINGSIDE = 4;
+const int BLACK_QUEENSIDE = 8;
+
+// Mailbox piece codes: side * 6 + piece type, or NO_PIECE for an empty square
+const int NO_PIECE = 12;
+
+// Earlier keys kept for repetition detection. Only positions since the last capture or pawn
+// move can repeat, and the fifty-move rule ends the game after 100 of those, so a ring buffer
+// of this size always reaches back far enough.
+const int KEY_HISTORY_SIZE = 128;
+
+constexpr int makePiece(int side, int type) { return side * 6 + type; }
+constexpr int pieceSide(int piece) { return piece / 6; }
+constexpr int pieceType(int piece) { return piece % 6; }
+
+// A complete, self-contained game position. Every board function takes one by reference,
+// so separate games or search threads each work on their own instance.
+struct Position {
+    uint64_t pieces[2][6];   // Piece bitboards, indexed [WHITE/BLACK][PAWN..KING]
+    uint64_t occupancy[2];   // All pieces of each side
+    uint64_t allPieces;
+    uint8_t mailbox[64];     // Piece code on each square, kept in sync with the bitboards
+    int castlingRights;      // WHITE_KINGSIDE | WHITE_QUEENSIDE | BLACK_KINGSIDE | BLACK_QUEENSIDE
+    uint64_t enPassantTarget;
+    bool whiteToMove;
+    uint64_t key;            // Zobrist key, updated incrementally by makeMove/unmakeMove
+    uint64_t pawnKey;        // Zobrist key of the pawns alone, for the pawn hash table
+    int psqtMidgame;         // Material + piece-square score (White minus Black) for the middlegame,
+    int psqtEndgame;         // and for the endgame; both updated with every piece added or removed
+    int phase;               // Non-pawn material left (see PHASE_WEIGHTS), for blending the two
+    int halfmoveClock;       // Plies since the last capture or pawn move
+    uint64_t keyHistory[KEY_HISTORY_SIZE]; // Keys of the positions before this one, by ply (ring buffer)
+    int historyLength;       // Plies played since the position was set up
+    NnueAccumulator accumulator; // Network input layer, kept up to date only while nnueEnabled
+
+    // Type of the piece on a square (-1 if empty)
+    int pieceTypeAt(int sq) const { return mailbox[sq] == NO_PIECE ? -1 : pieceType(mailbox[sq]); }
+};
+
+// Everything makeMove destroys, so unmakeMove can take the move back
+struct UndoInfo {
+    int capturedPiece;       // Piece type captured on the target square (-1 if none)
+    int castlingRights;
+    uint64_t enPassantTarget;
+    uint64_t key;            // Zobrist key before the move
+    int halfmoveClock;
+};
 
 // Zobrist hashing
-extern std::stack<uint64_t> zobristHistory;
-extern uint64_t zobristTable[12][64];
-extern std::unordered_map<uint64_t, std::pair<int, int>> transpositionTable;
+extern uint64_t zobristTable[12][64];     // Indexed [piece code][square]
+extern uint64_t zobristSide;              // Toggled when black is to move
+extern uint64_t zobristCastling[16];      // Indexed by the castling rights bitmask
+extern uint64_t zobristEnPassant[8];      // Indexed by the en passant file
 
-// Board functions
-void initializePosition();
-void printBitboard(uint64_t bitboard);
-void printBoardForPlayers();
-bool isSquareAttacked(uint64_t square, bool byWhite);
-bool isMoveLegal(uint64_t fromSquare, uint64_t toSquare, bool isWhite);
-std::vector<uint64_t> generatePawnMoves(uint64_t pawns, bool isWhite);
-std::vector<uint64_t> generateKnightMoves(uint64_t knights, bool isWhite);
-std::vector<uint64_t> generateBishopMoves(uint64_t bishops, bool isWhite);
-std::vector<uint64_t> generateRookMoves(uint64_t rooks, bool isWhite);
-std::vector<uint64_t> generateQueenMoves(uint64_t queens, bool isWhite);
-std::vector<uint64_t> generateKingMoves(uint64_t king, bool isWhite);
-bool canCastleKingside(bool isWhite);
-bool canCastleQueenside(bool isWhite);
-std::vector<uint64_t> generateEnPassantMoves(uint64_t pawns, bool isWhite);
-bool makeMove(int fromSquare, int toSquare, bool isWhiteTurn);
-void handlePawnPromotion(uint64_t toBit, uint64_t isWhiteTurn);
-bool isCheckmateOrStalemate(bool isWhiteTurn);
-
-// Sliding piece moves (rooks and bishops), with blockers
-uint64_t slideMove(uint64_t piece, int direction, uint64_t blockers);
-
-// Save and restore board state
-void saveBoardState(bool isWhiteTurn);
-void undoMove();
-
-// Convert a square in bitboard format to chess notation (e.g., 1ULL << 0 -> "a1")
-std::string squareToNotation(uint64_t square);
-
-// Board state
-extern uint64_t whitePawns, whiteKnights, whiteBishops, whiteRooks, whiteQueens, whiteKing;
-extern uint64_t blackPawns, blackKnights, blackBishops, blackRooks, blackQueens, blackKing;
-extern uint64_t whitePieces, blackPieces, allPieces;
-
-// Board structure
-struct Board {
-    uint64_t whitePawns, whiteKnights, whiteBishops, whiteRooks, whiteQueens, whiteKing;
-    uint64_t blackPawns, blackKnights, blackBishops, blackRooks, blackQueens, blackKing;
-    uint64_t whitePieces, blackPieces, allPieces;
-
-    int pieceTypeAt(int sq) const;
+void initializeZobrist();
+uint64_t computeKey(const Position& pos);
+
+// Legality information computed once per node by the legal move generator
+struct LegalityInfo {
+    int kingSquare;
+    uint64_t checkers;   // Enemy pieces giving check
+    uint64_t checkMask;  // Squares a non-king move must land on (all squares when not in check, none in double check)
+    uint64_t pinned;     // Own pieces pinned to the king
 };
 
-extern Board b; // Global board instance
-#endif // BOARD_H
\ No newline at end of file
+// Board functions
+void initializePosition(Position& pos);
+bool setPositionFromFen(Position& pos, const std::string& fen);
+void printBoardForPlayers(const Position& pos);
+bool isSquareAttacked(const Position& pos, uint64_t square, bool byWhite);
+uint64_t attackersTo(const Position& pos, int sq, uint64_t occupied);
+LegalityInfo computeLegalityInfo(const Position& pos);
+void generatePawnMoves(const Position& pos, const LegalityInfo& info, MoveList& moves);
+void generateKnightMoves(const Position& pos, const LegalityInfo& info, MoveList& moves);
+void generateBishopMoves(const Position& pos, const LegalityInfo& info, MoveList& moves);
+void generateRookMoves(const Position& pos, const LegalityInfo& info, MoveList& moves);
+void generateQueenMoves(const Position& pos, const LegalityInfo& info, MoveList& moves);
+void generateKingMoves(const Position& pos, const LegalityInfo& info, MoveList& moves);
+bool canCastleKingside(const Position& pos, bool isWhite);
+bool canCastleQueenside(const Position& pos, bool isWhite);
+void generateEnPassantMoves(const Position& pos, const LegalityInfo& info, MoveList& moves);
+void generateLegalMoves(const Position& pos, MoveList& moves);
+void generateCaptures(const Position& pos, MoveList& moves);
+bool isLegalMove(const Position& pos, Move move);
+bool isCapture(const Position& pos, Move move);
+UndoInfo makeMove(Position& pos, Move move);
+void unmakeMove(Position& pos, Move move, const UndoInfo& undo);
+bool makeMove(Position& pos, int fromSquare, int toSquare);
+UndoInfo makeNullMove(Position& pos);
+void unmakeNullMove(Position& pos, const UndoInfo& undo);
+bool hasLegalMove(const Position& pos);
+
+// Draw detection
+int repetitionCount(const Position& pos);
+bool isRepetition(const Position& pos);
+bool isDraw(const Position& pos);
+
+// Check if the side to move is in check
+bool isInCheck(const Position& pos);
+
+#endif // BOARD_H
@@ -1,19 +1,22 @@
 #include "evaluation.h"
+#include "psqt.h"
+#include "pawns.h"
+#include "nnue.h"
 #include "board.h"
 #include "../constants.h"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 
-// Piece values
-const int PAWN_VALUE = 100;
-const int KNIGHT_VALUE = 320;
-const int BISHOP_VALUE = 330;
-const int ROOK_VALUE = 500;
-const int QUEEN_VALUE = 900;
-const int KING_VALUE = 20000;
+// Global evaluation instance (read-only lookup tables, shared by all positions)
+Evaluation e;
 
-// Positional bonuses
-const int CENTER_CONTROL = 20; // Bonus for controlling central squares
-const uint64_t CENTER_MASK = 0x0000001818000000ULL; // Central squares (d4, d5, e4, e5)
+// Evaluation cache, direct-mapped by the low bits of the position key. Each entry is one 64-bit
+// word holding the key XORed with the score (in the low 16 bits). Reading XORs the key back out:
+// if anything is left above the score bits, the entry belongs to another position. Entries are
+// single atomic words, so all search threads share the cache without locks.
+const int EVAL_CACHE_SIZE = 1 << 16;
+static std::atomic<uint64_t> evalCache[EVAL_CACHE_SIZE];
 
 // Adjustments based on the number of pawns
 int knight_adj[9] = { -20, -16, -12, -8, -4,  0,  4,  8, 12 };
@@ -33,73 +36,11 @@ static const int SafetyTable[100] = {
   500, 500, 500, 500, 500, 500, 500, 500, 500, 500
 };
 
-// Evaluate pawn structure
-int evaluatePawnStructure(int side) {
-    int score = 0;
-    uint64_t pawns = (side == WHITE) ? b.whitePawns : b.blackPawns;
-    uint64_t enemyPawns = (side == WHITE) ? b.blackPawns : b.whitePawns;
-    int step = (side == WHITE) ? 8 : -8; // Direction of pawn movement
-
-    while (pawns) {
-        int sq = __builtin_ctzll(pawns);
-        pawns &= pawns - 1;
-
-        int file = sq % 8;
-        int rank = sq / 8;
-
-        // Check for passed pawns
-        bool isPassed = true;
-        for (int r = rank + step; r >= 0 && r < 8; r += step) {
-            if (enemyPawns & (1ULL << (file + r * 8))) {
-                isPassed = false;
-                break;
-            }
-        }
-
-        if (isPassed) {
-            score += 50; // Bonus for passed pawns
-        }
-
-        // Check for isolated pawns
-        bool isIsolated = true;
-        if (file > 0 && (pawns & (1ULL << (sq - 1)))) isIsolated = false; // Left file
-        if (file < 7 && (pawns & (1ULL << (sq + 1)))) isIsolated = false; // Right file
-
-        if (isIsolated) {
-            score -= 20; // Penalty for isolated pawns
-        }
-
-        // Check for doubled pawns
-        bool isDoubled = false;
-        for (int r = rank + step; r >= 0 && r < 8; r += step) {
-            if (pawns & (1ULL << (file + r * 8))) {
-                isDoubled = true;
-                break;
-            }
-        }
-
-        if (isDoubled) {
-            score -= 15; // Penalty for doubled pawns
-        }
-
-        // Check for backward pawns
-        bool isBackward = true;
-        if (file > 0 && (pawns & (1ULL << (sq - 1 + step)))) isBackward = false; // Left diagonal
-        if (file < 7 && (pawns & (1ULL << (sq + 1 + step)))) isBackward = false; // Right diagonal
-
-        if (isBackward) {
-            score -= 10; // Penalty for backward pawns
-        }
-    }
-
-    return score;
-}
-
 // Evaluate king safety
-int evaluateKingSafety(int side) {
+int evaluateKingSafety(const Position& pos, int side) {
     int score = 0;
-    int kingSq = (side == WHITE) ? __builtin_ctzll(b.whiteKing) : __builtin_ctzll(b.blackKing);
-    uint64_t enemyPieces = (side == WHITE) ? b.blackPieces : b.whitePieces;
+    int kingSq = (side == WHITE) ? __builtin_ctzll(pos.pieces[WHITE][KING]) : __builtin_ctzll(pos.pieces[BLACK][KING]);
+    uint64_t enemyPieces = (side == WHITE) ? pos.occupancy[BLACK] : pos.occupancy[WHITE];
 
     // King shield evaluation
     int kingFile = kingSq % 8;
@@ -112,8 +53,8 @@ int evaluateKingSafety(int side) {
 
         int shieldSq = kingRank + (side == WHITE ? 1 : -1) * 8 + file;
         if (shieldSq >= 0 && shieldSq < 64) {
-            if ((side == WHITE && (b.whitePawns & (1ULL << shieldSq))) ||
-                (side == BLACK && (b.blackPawns & (1ULL << shieldSq)))) {
+            if ((side == WHITE && (pos.pieces[WHITE][PAWN] & (1ULL << shieldSq))) ||
+                (side == BLACK && (pos.pieces[BLACK][PAWN] & (1ULL << shieldSq)))) {
                 score += 20; // Bonus for pawns in the king shield
             }
         }
@@ -127,7 +68,7 @@ int evaluateKingSafety(int side) {
         bool isOpen = true;
         for (int rank = 0; rank < 8; rank++) {
             int sq = file + rank * 8;
-            if ((b.whitePawns & (1ULL << sq)) || (b.blackPawns & (1ULL << sq))) {
+            if ((pos.pieces[WHITE][PAWN] & (1ULL << sq)) || (pos.pieces[BLACK][PAWN] & (1ULL << sq))) {
                 isOpen = false;
                 break;
             }
@@ -152,34 +93,19 @@ int evaluateKingSafety(int side) {
     return score;
 }
 
-// Locate pieces to evalate mobility
-int Board::pieceTypeAt(int sq) const {
-    uint64_t mask = 1ULL << sq;
-
-    if (whitePawns & mask || blackPawns & mask)     return PAWN;
-    if (whiteKnights & mask || blackKnights & mask) return KNIGHT;
-    if (whiteBishops & mask || blackBishops & mask) return BISHOP;
-    if (whiteRooks & mask || blackRooks & mask)     return ROOK;
-    if (whiteQueens & mask || blackQueens & mask)   return QUEEN;
-    if (whiteKing & mask || blackKing & mask)       return KING;
-
-    return -1; // Empty square
-}
-
-
 // Evaluate mobility
-int evaluateMobility(int side) {
+int evaluateMobility(const Position& pos, int side) {
     int score = 0;
-    uint64_t pieces = (side == WHITE) ? b.whitePieces : b.blackPieces;
-    uint64_t enemyPieces = (side == WHITE) ? b.blackPieces : b.whitePieces;
-    uint64_t allPieces = b.whitePieces | b.blackPieces;
+    uint64_t pieces = (side == WHITE) ? pos.occupancy[WHITE] : pos.occupancy[BLACK];
+    uint64_t enemyPieces = (side == WHITE) ? pos.occupancy[BLACK] : pos.occupancy[WHITE];
+    uint64_t allPieces = pos.occupancy[WHITE] | pos.occupancy[BLACK];
 
     while (pieces) {
         int sq = __builtin_ctzll(pieces);
         pieces &= pieces - 1;
 
         int mobility = 0;
-        int pieceType = b.pieceTypeAt(sq);
+        int pieceType = pos.pieceTypeAt(sq);
 
         switch (pieceType) {
             case KNIGHT:
@@ -217,7 +143,7 @@ int evaluateMobility(int side) {
         }
 
         // Proximity to enemy king
-        int enemyKingSq = (side == WHITE) ? __builtin_ctzll(b.blackKing) : __builtin_ctzll(b.whiteKing);
+        int enemyKingSq = (side == WHITE) ? __builtin_ctzll(pos.pieces[BLACK][KING]) : __builtin_ctzll(pos.pieces[WHITE][KING]);
         if (e.sqNearK[!side][enemyKingSq][sq]) {
             mobility += 3;
         }
@@ -229,47 +155,53 @@ int evaluateMobility(int side) {
 }
 
 
-// Evaluate the current position
-int evaluatePosition() {
-    int whiteScore = 0, blackScore = 0;
+bool setEvalBackend(EvalBackend backend) {
+    if (backend == EVAL_NNUE && !networkLoaded()) return false;
+    nnueEnabled = backend == EVAL_NNUE;
+    for (std::atomic<uint64_t>& entry : evalCache) entry.store(0, std::memory_order_relaxed);
+    return true;
+}
 
-    // Calculate material score
-    whiteScore += __builtin_popcountll(b.whitePawns) * PAWN_VALUE;
-    whiteScore += __builtin_popcountll(b.whiteKnights) * KNIGHT_VALUE;
-    whiteScore += __builtin_popcountll(b.whiteBishops) * BISHOP_VALUE;
-    whiteScore += __builtin_popcountll(b.whiteRooks) * ROOK_VALUE;
-    whiteScore += __builtin_popcountll(b.whiteQueens) * QUEEN_VALUE;
-    whiteScore += __builtin_popcountll(b.whiteKing) * KING_VALUE;
-
-    blackScore += __builtin_popcountll(b.blackPawns) * PAWN_VALUE;
-    blackScore += __builtin_popcountll(b.blackKnights) * KNIGHT_VALUE;
-    blackScore += __builtin_popcountll(b.blackBishops) * BISHOP_VALUE;
-    blackScore += __builtin_popcountll(b.blackRooks) * ROOK_VALUE;
-    blackScore += __builtin_popcountll(b.blackQueens) * QUEEN_VALUE;
-    blackScore += __builtin_popcountll(b.blackKing) * KING_VALUE;
-
-    // Add bonuses for center control
-    whiteScore += __builtin_popcountll(b.whitePieces & CENTER_MASK) * CENTER_CONTROL;
-    blackScore += __builtin_popcountll(b.blackPieces & CENTER_MASK) * CENTER_CONTROL;
+// Hand-written evaluation
+static int evaluateClassical(const Position& pos) {
+    // Material, piece squares and center control come from the position's running totals,
+    // blended from the middlegame to the endgame as material comes off
+    int phase = std::min(pos.phase, MAX_PHASE);
+    int score = (pos.psqtMidgame * phase + pos.psqtEndgame * (MAX_PHASE - phase)) / MAX_PHASE;
+
+    int whiteScore = 0, blackScore = 0;
 
     // Adjust material based on pawn count
-    whiteScore += knight_adj[__builtin_popcountll(b.whitePawns)];
-    blackScore += knight_adj[__builtin_popcountll(b.blackPawns)];
-    whiteScore += rook_adj[__builtin_popcountll(b.whitePawns)];
-    blackScore += rook_adj[__builtin_popcountll(b.blackPawns)];
+    int whitePawns = __builtin_popcountll(pos.pieces[WHITE][PAWN]);
+    int blackPawns = __builtin_popcountll(pos.pieces[BLACK][PAWN]);
+    whiteScore += knight_adj[whitePawns] + rook_adj[whitePawns];
+    blackScore += knight_adj[blackPawns] + rook_adj[blackPawns];
 
-    // Evaluate pawn structure
-    whiteScore += evaluatePawnStructure(WHITE);
-    blackScore += evaluatePawnStructure(BLACK);
+    // Pawn structure, usually straight from the pawn hash table
+    const PawnEntry& pawns = probePawnTable(pos);
+    whiteScore += pawns.score[WHITE];
+    blackScore += pawns.score[BLACK];
 
     // Evaluate king safety
-    whiteScore += evaluateKingSafety(WHITE);
-    blackScore += evaluateKingSafety(BLACK);
+    whiteScore += evaluateKingSafety(pos, WHITE);
+    blackScore += evaluateKingSafety(pos, BLACK);
 
     // Evaluate mobility
-    whiteScore += evaluateMobility(WHITE);
-    blackScore += evaluateMobility(BLACK);
+    whiteScore += evaluateMobility(pos, WHITE);
+    blackScore += evaluateMobility(pos, BLACK);
 
     // Return evaluation (positive if White is better, negative if Black is better)
-    return whiteScore - blackScore;
-}
\ No newline at end of file
+    return score + whiteScore - blackScore;
+}
+
+// Evaluate the current position
+int evaluatePosition(const Position& pos) {
+    std::atomic<uint64_t>& cacheEntry = evalCache[pos.key & (EVAL_CACHE_SIZE - 1)];
+    uint64_t cached = cacheEntry.load(std::memory_order_relaxed) ^ pos.key;
+    if (!(cached >> 16)) return int16_t(cached);
+
+    // The network scores for the side to move
+    int score = nnueEnabled ? (pos.whiteToMove ? nnueEvaluate(pos) : -nnueEvaluate(pos)) : evaluateClassical(pos);
+    cacheEntry.store(pos.key ^ uint16_t(int16_t(score)), std::memory_order_relaxed);
+    return score;
+}
@@ -3,8 +3,31 @@
 
 #include <cstdint>
 
-// Evaluation functions
-int evaluatePosition();
+#include "board.h"
+
+// Piece values
+const int PAWN_VALUE = 100;
+const int KNIGHT_VALUE = 320;
+const int BISHOP_VALUE = 330;
+const int ROOK_VALUE = 500;
+const int QUEEN_VALUE = 900;
+const int KING_VALUE = 20000;
+
+// Indexed by piece type
+const int PIECE_VALUES[6] = {PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_VALUE};
+
+// Evaluation functions (positive if White is better)
+int evaluatePosition(const Position& pos);
+
+// Evaluation backends: the hand-written terms below, or the network in nnue.h
+enum EvalBackend {
+    EVAL_CLASSICAL,
+    EVAL_NNUE
+};
+
+// Switch backends (false if NNUE is asked for without a loaded network). Clears the evaluation
+// cache; positions must be set up again afterwards so their accumulators are filled in.
+bool setEvalBackend(EvalBackend backend);
 
 // Evaluation structure
 struct Evaluation {
@@ -4,9 +4,8 @@
 #include <vector>
 #include <algorithm>
 #include <limits>
-#include <stack>
 #include <random>
-#include <unordered_map>
+#include <chrono>
 
 #include "evaluation.h"
 #include "board.h"
@@ -15,26 +14,41 @@
 #include "../gui/gui.h"
 
 
+// Announce a draw by the fifty-move rule or threefold repetition; returns true if the game is over
+static bool announceDraw(const Position& pos) {
+    if (pos.halfmoveClock >= 100) {
+        std::cout << "Fifty moves without a capture or pawn move. The game is a draw." << std::endl;
+        return true;
+    }
+    if (repetitionCount(pos) >= 2) {
+        std::cout << "Threefold repetition. The game is a draw." << std::endl;
+        return true;
+    }
+    return false;
+}
+
 // Game loop for human vs. human gameplay
 void gameLoop() {
-    bool isWhiteTurn = true;
-    initializePosition();
-    printBoardForPlayers();
+    Position pos;
+    initializePosition(pos);
+    printBoardForPlayers(pos);
 
     while (true) {
-        if (isCheckmateOrStalemate(isWhiteTurn)) {
-            if (isSquareAttacked(isWhiteTurn ? whiteKing : blackKing, !isWhiteTurn)) {
+        bool isWhiteTurn = pos.whiteToMove;
+        if (!hasLegalMove(pos)) {
+            if (isInCheck(pos)) {
                 std::cout << (isWhiteTurn ? "Black wins by checkmate!" : "White wins by checkmate!") << std::endl;
             } else {
                 std::cout << "Stalemate! The game is a draw." << std::endl;
             }
             break;
         }
+        if (announceDraw(pos)) break;
 
         // Display turn and take input
         std::cout << (isWhiteTurn ? "White's turn: " : "Black's turn: ");
         std::string moveInput;
-        getline(std::cin, moveInput);
+        if (!getline(std::cin, moveInput)) return; // Input closed
 
         if (moveInput.size() != 5 || moveInput[2] != ' ') {
             std::cout << "Invalid input format. Use format 'e2 e4'.\n";
@@ -42,40 +56,64 @@ void gameLoop() {
         }
 
         auto [fromSquare, toSquare] = parseInput(moveInput);
-        if (makeMove(fromSquare, toSquare, isWhiteTurn)) {
-            printBoardForPlayers();
-            int score = evaluatePosition();
+        if (makeMove(pos, fromSquare, toSquare)) {
+            printBoardForPlayers(pos);
+            int score = evaluatePosition(pos);
             std::cout << "Evaluation Score: " << score << " ("
                  << (score > 0 ? "White is better" : (score < 0 ? "Black is better" : "Equal"))
                  << ")\n";
-            isWhiteTurn = !isWhiteTurn;
         } else {
             std::cout << "Invalid move. Try again.\n";
         }
     }
 }
 
-// Game loop for playing against the computer
-void computerGameLoop(bool humanPlaysWhite) {
-    bool isWhiteTurn = true;
-    initializePosition();
-    printBoardForPlayers();
+// Clock for games against the computer: 5 minutes each plus 2 seconds per move
+const int GAME_TIME_MS = 5 * 60 * 1000;
+const int INCREMENT_MS = 2000;
+
+// Search limits for the computer from the current clocks
+static SearchLimits clockLimits(const int clock[2]) {
+    SearchLimits limits;
+    limits.wtime = clock[WHITE];
+    limits.btime = clock[BLACK];
+    limits.winc = limits.binc = INCREMENT_MS;
+    return limits;
+}
+
+// Game loop for playing against the computer. With ponder on, the computer keeps searching
+// while the human thinks, on the reply it expects.
+void computerGameLoop(bool humanPlaysWhite, bool ponder) {
+    Position pos;
+    initializePosition(pos);
+    printBoardForPlayers(pos);
+
+    int clock[2] = {GAME_TIME_MS, GAME_TIME_MS};
+
+    // Start of the current turn; rejected input does not restart it, so the clock keeps running
+    auto moveStart = std::chrono::steady_clock::now();
 
     while (true) {
-        if (isCheckmateOrStalemate(isWhiteTurn)) {
-            if (isSquareAttacked(isWhiteTurn ? whiteKing : blackKing, !isWhiteTurn)) {
+        bool isWhiteTurn = pos.whiteToMove;
+        int side = isWhiteTurn ? WHITE : BLACK;
+
+        if (!hasLegalMove(pos)) {
+            if (isInCheck(pos)) {
                 std::cout << (isWhiteTurn ? "Black wins by checkmate!" : "White wins by checkmate!") << std::endl;
             } else {
                 std::cout << "Stalemate! The game is a draw." << std::endl;
             }
             break;
         }
+        if (announceDraw(pos)) break;
+
+        Move expectedReply = NO_MOVE;
 
         if ((isWhiteTurn && humanPlaysWhite) || (!isWhiteTurn && !humanPlaysWhite)) {
             // Human move
             std::cout << (isWhiteTurn ? "White's turn: " : "Black's turn: ");
             std::string moveInput;
-            getline(std::cin, moveInput);
+            if (!getline(std::cin, moveInput)) break; // Input closed
 
             if (moveInput.size() != 5 || moveInput[2] != ' ') {
                 std::cout << "Invalid input format. Use format 'e2 e4'.\n";
@@ -86,23 +124,48 @@ void computerGameLoop(bool humanPlaysWhite) {
             int fromSquare = parsedMove.first;
             int toSquare = parsedMove.second;
 
-            if (!makeMove(fromSquare, toSquare, isWhiteTurn)) {
+            if (!makeMove(pos, fromSquare, toSquare)) {
                 std::cout << "Invalid move. Try again.\n";
                 continue;
             }
         } else {
             // Computer move
             std::cout << "Computer is thinking...\n";
-            Move bestMove = findBestMove(isWhiteTurn);
-            if (bestMove.from == 0 && bestMove.to == 0) {
+            SearchLimits limits = clockLimits(clock);
+
+            // If the human played the expected reply, the ponder search has a head start
+            SearchResult bestMove;
+            if (!finishPondering(pos, bestMove)) bestMove = findBestMove(pos, limits);
+            if (bestMove.move == NO_MOVE) {
                 std::cout << "No legal moves available for AI. Game over.\n";
                 break;
             }
-            makeMove(bestMove.from, bestMove.to, isWhiteTurn);
-            std::cout << "Computer's move: Evaluation = " << bestMove.evaluation << std::endl;
+            makeMove(pos, bestMove.move);
+            std::cout << "Computer's move: " << moveToNotation(bestMove.move)
+                      << " Evaluation = " << bestMove.evaluation << std::endl;
+            expectedReply = bestMove.ponderMove;
         }
 
-        printBoardForPlayers();
-        isWhiteTurn = !isWhiteTurn;
+        // Charge the time spent on this move and add the increment
+        clock[side] -= int(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - moveStart).count());
+        moveStart = std::chrono::steady_clock::now();
+
+        // A move made after the flag fell does not count, whatever it did to the other side
+        if (clock[side] <= 0) {
+            std::cout << (isWhiteTurn ? "White" : "Black") << " ran out of time. "
+                      << (isWhiteTurn ? "Black" : "White") << " wins!" << std::endl;
+            break;
+        }
+        clock[side] += INCREMENT_MS;
+
+        // Think about the expected reply on the human's time; the computer's clock does not run
+        // meanwhile, so the limits are already right if the human plays it
+        if (ponder && expectedReply != NO_MOVE) startPondering(pos, expectedReply, clockLimits(clock));
+
+        printBoardForPlayers(pos);
+        std::cout << "Clock: White " << clock[WHITE] / 1000 << "s, Black " << clock[BLACK] / 1000 << "s\n";
     }
+
+    stopPondering();
 }
@@ -6,6 +6,6 @@
 #define GAMELOOPS_H
 
 void gameLoop();
-void computerGameLoop(bool humanPlaysWhite);
+void computerGameLoop(bool humanPlaysWhite, bool ponder = false);
 
 #endif //GAMELOOPS_H
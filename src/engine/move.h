@@ -0,0 +1,49 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <cstdint>
+
+#include "../constants.h"
+
+// Packed 16-bit move
+//   bits 0-5   from square
+//   bits 6-11  to square
+//   bits 12-13 promotion piece (KNIGHT, BISHOP, ROOK or QUEEN, stored as piece - KNIGHT)
+//   bits 14-15 move flag
+using Move = uint16_t;
+
+const Move NO_MOVE = 0;
+
+// Move flags
+const int MOVE_NORMAL = 0;
+const int MOVE_PROMOTION = 1;
+const int MOVE_EN_PASSANT = 2;
+const int MOVE_CASTLING = 3;
+
+inline Move encodeMove(int from, int to, int flag = MOVE_NORMAL, int promotionPiece = KNIGHT) {
+    return Move(from | (to << 6) | ((promotionPiece - KNIGHT) << 12) | (flag << 14));
+}
+
+inline int moveFrom(Move move) { return move & 0x3F; }
+inline int moveTo(Move move) { return (move >> 6) & 0x3F; }
+inline int moveFlag(Move move) { return move >> 14; }
+inline int movePromotion(Move move) { return ((move >> 12) & 3) + KNIGHT; }
+
+// Enough for any legal chess position (the known maximum is 218)
+const int MAX_MOVES = 256;
+
+// Fixed-capacity move list that lives on the stack
+struct MoveList {
+    Move moves[MAX_MOVES];
+    int count = 0;
+
+    void add(Move move) { moves[count++] = move; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](int i) { return moves[i]; }
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+};
+
+#endif // MOVE_H
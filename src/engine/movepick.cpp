@@ -0,0 +1,232 @@
+#include "movepick.h"
+#include "evaluation.h"
+#include "attacks.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// Picker stages, in the order they are handed out
+enum Stage {
+    STAGE_TT_MOVE,
+    STAGE_GENERATE_CAPTURES,
+    STAGE_GOOD_CAPTURES,
+    STAGE_KILLER_1,
+    STAGE_KILLER_2,
+    STAGE_GENERATE_QUIETS,
+    STAGE_QUIETS,
+    STAGE_BAD_CAPTURES,
+    STAGE_DONE
+};
+
+void SearchHistory::clear() {
+    std::memset(killers, 0, sizeof(killers));
+    std::memset(history, 0, sizeof(history));
+}
+
+void SearchHistory::newSearch() {
+    std::memset(killers, 0, sizeof(killers));
+    for (auto& side : history) {
+        for (auto& from : side) {
+            for (int& score : from) score /= 2;
+        }
+    }
+}
+
+// Nudge a history score toward +-HISTORY_MAX; large scores move less, so none saturate
+static void updateHistoryScore(int& score, int bonus) {
+    score += bonus - score * std::abs(bonus) / HISTORY_MAX;
+}
+
+// A quiet move caused a beta cutoff: remember it as a killer, reward it and
+// penalise the quiet moves that were tried before it and failed
+void SearchHistory::updateQuietCutoff(const Position& pos, Move move, int ply, int depth,
+                                      const Move* failedQuiets, int failedCount) {
+    if (ply < MAX_PLY && killers[ply][0] != move) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    int side = pos.whiteToMove ? WHITE : BLACK;
+    int bonus = std::min(depth * depth, 400);
+    updateHistoryScore(history[side][moveFrom(move)][moveTo(move)], bonus);
+    for (int i = 0; i < failedCount; ++i) {
+        updateHistoryScore(history[side][moveFrom(failedQuiets[i])][moveTo(failedQuiets[i])], -bonus);
+    }
+}
+
+// Most valuable victim, least valuable attacker
+int mvvLva(const Position& pos, Move move) {
+    int victim = moveFlag(move) == MOVE_EN_PASSANT ? PAWN : pos.pieceTypeAt(moveTo(move));
+    int score = victim >= 0 ? PIECE_VALUES[victim] * 10 - pos.pieceTypeAt(moveFrom(move)) : 0;
+    if (moveFlag(move) == MOVE_PROMOTION) score += PIECE_VALUES[movePromotion(move)] * 10;
+    return score;
+}
+
+// Static exchange evaluation: the material a move wins or loses once both sides have made every
+// profitable recapture on its target square, cheapest attacker first. Sliders hidden behind a
+// piece that has captured (x-rays) join the exchange as the board opens up. Pins are ignored.
+int see(const Position& pos, Move move) {
+    if (moveFlag(move) == MOVE_CASTLING) return 0;
+
+    int from = moveFrom(move);
+    int to = moveTo(move);
+    uint64_t occupied = pos.allPieces;
+    int attacker = pos.pieceTypeAt(from);
+    int victim = pos.pieceTypeAt(to);
+
+    // gain[d] is the score, from the point of view of the side making capture d, if the exchange
+    // stops after that capture
+    int gain[32];
+    int d = 0;
+    gain[0] = victim >= 0 ? PIECE_VALUES[victim] : 0;
+    if (moveFlag(move) == MOVE_EN_PASSANT) {
+        gain[0] = PAWN_VALUE;
+        occupied ^= 1ULL << (pos.whiteToMove ? to - 8 : to + 8);
+    } else if (moveFlag(move) == MOVE_PROMOTION) {
+        attacker = movePromotion(move);
+        gain[0] += PIECE_VALUES[attacker] - PAWN_VALUE;
+    }
+
+    uint64_t diagonal = pos.pieces[WHITE][BISHOP] | pos.pieces[BLACK][BISHOP] | pos.pieces[WHITE][QUEEN] | pos.pieces[BLACK][QUEEN];
+    uint64_t straight = pos.pieces[WHITE][ROOK] | pos.pieces[BLACK][ROOK] | pos.pieces[WHITE][QUEEN] | pos.pieces[BLACK][QUEEN];
+    uint64_t attackers = attackersTo(pos, to, occupied);
+    uint64_t fromBit = 1ULL << from;
+    int side = pos.whiteToMove ? WHITE : BLACK;
+
+    while (true) {
+        ++d;
+        gain[d] = PIECE_VALUES[attacker] - gain[d - 1]; // The piece just moved is captured next
+        if (std::max(-gain[d - 1], gain[d]) < 0) break; // Neither side can improve by continuing
+
+        // Remove the capturing piece and uncover any slider lined up behind it
+        occupied ^= fromBit;
+        attackers &= occupied;
+        attackers |= (bishopAttacks(to, occupied) & diagonal & occupied) | (rookAttacks(to, occupied) & straight & occupied);
+
+        // The other side recaptures with its least valuable attacker
+        side ^= 1;
+        uint64_t ours = attackers & pos.occupancy[side];
+        if (!ours) break;
+        for (attacker = PAWN; attacker <= KING; ++attacker) {
+            if (ours & pos.pieces[side][attacker]) break;
+        }
+        fromBit = ours & pos.pieces[side][attacker] & -(ours & pos.pieces[side][attacker]);
+
+        // A king may only recapture if nothing can take it back
+        if (attacker == KING && (attackers & pos.occupancy[side ^ 1] & ~fromBit)) break;
+    }
+
+    // Walk the swap list backwards: each side stops the exchange when continuing would lose
+    while (--d) gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+    return gain[0];
+}
+
+// A capture that loses material once the exchange is played out. Taking a piece worth at least
+// as much as the capturer never loses, so the full exchange is only worked out otherwise.
+bool isLosingCapture(const Position& pos, Move move) {
+    if (moveFlag(move) != MOVE_NORMAL) return false;
+    int attacker = pos.pieceTypeAt(moveFrom(move));
+    int victim = pos.pieceTypeAt(moveTo(move));
+    if (victim >= 0 && PIECE_VALUES[attacker] <= PIECE_VALUES[victim]) return false;
+    return see(pos, move) < 0;
+}
+
+// Neither a capture nor a promotion (those come from the capture stages)
+static bool isQuiet(const Position& pos, Move move) {
+    return !isCapture(pos, move) && moveFlag(move) != MOVE_PROMOTION;
+}
+
+MovePicker::MovePicker(const Position& pos, Move ttMove, const SearchHistory& history, int ply)
+    : pos(pos), history(&history), ttMove(ttMove), stage(STAGE_TT_MOVE), capturesOnly(false) {
+    killers[0] = ply < MAX_PLY ? history.killers[ply][0] : NO_MOVE;
+    killers[1] = ply < MAX_PLY ? history.killers[ply][1] : NO_MOVE;
+}
+
+MovePicker::MovePicker(const Position& pos)
+    : pos(pos), history(nullptr), ttMove(NO_MOVE), killers{NO_MOVE, NO_MOVE},
+      stage(STAGE_GENERATE_CAPTURES), capturesOnly(true) {}
+
+// Selection sort step: move the highest-scored remaining move to the front and return it.
+// Cutoffs usually come early, so most of the list is never sorted.
+Move MovePicker::pickBest() {
+    int best = current;
+    for (int i = current + 1; i < moves.size(); ++i) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    std::swap(moves[current], moves[best]);
+    std::swap(scores[current], scores[best]);
+    return moves[current++];
+}
+
+Move MovePicker::next() {
+    switch (stage) {
+        case STAGE_TT_MOVE:
+            ++stage;
+            if (ttMove != NO_MOVE && isLegalMove(pos, ttMove)) return ttMove;
+            [[fallthrough]];
+
+        case STAGE_GENERATE_CAPTURES:
+            generateCaptures(pos, moves);
+            for (int i = 0; i < moves.size(); ++i) scores[i] = mvvLva(pos, moves[i]);
+            current = 0;
+            ++stage;
+            [[fallthrough]];
+
+        case STAGE_GOOD_CAPTURES:
+            while (current < moves.size()) {
+                Move move = pickBest();
+                if (move == ttMove) continue;
+                if (isLosingCapture(pos, move)) {
+                    if (!capturesOnly) badCaptures.add(move);
+                    continue;
+                }
+                return move;
+            }
+            if (capturesOnly) {
+                stage = STAGE_DONE;
+                return NO_MOVE;
+            }
+            ++stage;
+            [[fallthrough]];
+
+        case STAGE_KILLER_1:
+        case STAGE_KILLER_2:
+            while (stage <= STAGE_KILLER_2) {
+                Move killer = killers[stage - STAGE_KILLER_1];
+                ++stage;
+                if (killer != NO_MOVE && killer != ttMove && isQuiet(pos, killer) && isLegalMove(pos, killer)) {
+                    return killer;
+                }
+            }
+            [[fallthrough]];
+
+        case STAGE_GENERATE_QUIETS: {
+            MoveList all;
+            generateLegalMoves(pos, all);
+            moves.count = 0;
+            int side = pos.whiteToMove ? WHITE : BLACK;
+            for (Move move : all) {
+                if (move == ttMove || move == killers[0] || move == killers[1] || !isQuiet(pos, move)) continue;
+                scores[moves.size()] = history->history[side][moveFrom(move)][moveTo(move)];
+                moves.add(move);
+            }
+            current = 0;
+            ++stage;
+        }
+            [[fallthrough]];
+
+        case STAGE_QUIETS:
+            if (current < moves.size()) return pickBest();
+            ++stage;
+            [[fallthrough]];
+
+        case STAGE_BAD_CAPTURES:
+            if (badCurrent < badCaptures.size()) return badCaptures[badCurrent++];
+            stage = STAGE_DONE;
+            [[fallthrough]];
+
+        default:
+            return NO_MOVE;
+    }
+}
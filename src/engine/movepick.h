@@ -0,0 +1,59 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include <cstdint>
+
+#include "board.h"
+#include "move.h"
+
+// Deepest ply the search can reach (killer slots are indexed by ply)
+const int MAX_PLY = 128;
+
+// Largest magnitude a history score can reach
+const int HISTORY_MAX = 16384;
+
+// Ordering knowledge gathered during a search
+struct SearchHistory {
+    Move killers[MAX_PLY][2];   // Quiet moves that recently caused a beta cutoff at each ply
+    int history[2][64][64];     // Butterfly table: [side][from][to], higher means more cutoffs
+
+    void clear();
+    void newSearch();           // Forget killers and fade history between searches
+    void updateQuietCutoff(const Position& pos, Move move, int ply, int depth,
+                           const Move* failedQuiets, int failedCount);
+};
+
+// Move ordering helpers shared with the search
+int mvvLva(const Position& pos, Move move);
+int see(const Position& pos, Move move);
+bool isLosingCapture(const Position& pos, Move move);
+
+// Hands out moves one at a time, generating each stage only when the previous one runs out:
+// TT move, good captures (MVV-LVA), killers, quiets (by history), bad captures
+struct MovePicker {
+    // Main search
+    MovePicker(const Position& pos, Move ttMove, const SearchHistory& history, int ply);
+    // Quiescence search: captures and promotions only, losing captures skipped
+    explicit MovePicker(const Position& pos);
+
+    // The next move to try, or NO_MOVE once every stage is exhausted
+    Move next();
+
+private:
+    const Position& pos;
+    const SearchHistory* history;
+    Move ttMove;
+    Move killers[2];
+    int stage;
+    bool capturesOnly;
+
+    MoveList moves;
+    int scores[MAX_MOVES];
+    int current = 0;
+    MoveList badCaptures;
+    int badCurrent = 0;
+
+    Move pickBest();
+};
+
+#endif // MOVEPICK_H
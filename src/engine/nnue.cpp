@@ -0,0 +1,308 @@
+#include "nnue.h"
+#include "board.h"
+#include "ai.h"
+#include "../constants.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NNUE_X86 1
+#include <immintrin.h>
+#endif
+
+bool nnueEnabled = false;
+
+// Network dimensions
+const int KING_BUCKET_SIZE = 641;                            // 10 piece kinds * 64 squares + 1
+const int INPUT_DIMENSIONS = 64 * KING_BUCKET_SIZE;          // 41024
+const int TRANSFORMED_DIMENSIONS = 2 * NNUE_HALF_DIMENSIONS; // 512
+const int HIDDEN_DIMENSIONS = 32;
+
+// File format constants
+const uint32_t NNUE_VERSION = 0x7AF32F16;
+const uint32_t MAX_DESCRIPTION_LENGTH = 1 << 20;
+
+// Quantisation: hidden sums carry 6 fractional bits, and the output is in units of 1/16 of an
+// internal pawn worth 208
+const int WEIGHT_SCALE_BITS = 6;
+const int OUTPUT_SCALE = 16;
+const int OUTPUT_PAWN_VALUE = 208;
+
+struct Network {
+    std::vector<int16_t> transformerBiases;   // [neuron]
+    std::vector<int16_t> transformerWeights;  // [feature][neuron]
+    alignas(32) int32_t hidden1Biases[HIDDEN_DIMENSIONS];
+    alignas(32) int8_t hidden1Weights[HIDDEN_DIMENSIONS * TRANSFORMED_DIMENSIONS];  // [output][input]
+    alignas(32) int32_t hidden2Biases[HIDDEN_DIMENSIONS];
+    alignas(32) int8_t hidden2Weights[HIDDEN_DIMENSIONS * HIDDEN_DIMENSIONS];
+    int32_t outputBias;
+    alignas(32) int8_t outputWeights[HIDDEN_DIMENSIONS];
+};
+
+static std::unique_ptr<Network> network;
+
+// ---------------------------------------------------------------------------------------------
+// Kernels. Each set adds or subtracts one transformer weight row to an accumulator and takes
+// the dot product of unsigned 8-bit activations with signed 8-bit weights (a multiple of 32
+// long). Activations are at most 127, so the pairwise 16-bit sums of the SIMD versions cannot
+// saturate and every set gives exactly the same results.
+
+struct Kernels {
+    void (*addRow)(int16_t* accumulator, const int16_t* row);
+    void (*subtractRow)(int16_t* accumulator, const int16_t* row);
+    int32_t (*dot)(const uint8_t* input, const int8_t* weights, int size);
+};
+
+static void addRowScalar(int16_t* accumulator, const int16_t* row) {
+    for (int i = 0; i < NNUE_HALF_DIMENSIONS; ++i) accumulator[i] += row[i];
+}
+
+static void subtractRowScalar(int16_t* accumulator, const int16_t* row) {
+    for (int i = 0; i < NNUE_HALF_DIMENSIONS; ++i) accumulator[i] -= row[i];
+}
+
+static int32_t dotScalar(const uint8_t* input, const int8_t* weights, int size) {
+    int32_t sum = 0;
+    for (int i = 0; i < size; ++i) sum += int32_t(input[i]) * weights[i];
+    return sum;
+}
+
+#ifdef NNUE_X86
+__attribute__((target("avx2")))
+static void addRowAvx2(int16_t* accumulator, const int16_t* row) {
+    for (int i = 0; i < NNUE_HALF_DIMENSIONS; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulator + i), _mm256_add_epi16(a, r));
+    }
+}
+
+__attribute__((target("avx2")))
+static void subtractRowAvx2(int16_t* accumulator, const int16_t* row) {
+    for (int i = 0; i < NNUE_HALF_DIMENSIONS; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulator + i), _mm256_sub_epi16(a, r));
+    }
+}
+
+__attribute__((target("avx2")))
+static int32_t dotAvx2(const uint8_t* input, const int8_t* weights, int size) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < size; i += 32) {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        // u8 * i8 products summed in pairs to i16, then in pairs again to i32
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(in, w), ones));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+}
+
+__attribute__((target("sse4.1")))
+static void addRowSse4(int16_t* accumulator, const int16_t* row) {
+    for (int i = 0; i < NNUE_HALF_DIMENSIONS; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+        __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulator + i), _mm_add_epi16(a, r));
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void subtractRowSse4(int16_t* accumulator, const int16_t* row) {
+    for (int i = 0; i < NNUE_HALF_DIMENSIONS; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+        __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulator + i), _mm_sub_epi16(a, r));
+    }
+}
+
+__attribute__((target("sse4.1")))
+static int32_t dotSse4(const uint8_t* input, const int8_t* weights, int size) {
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < size; i += 16) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(in, w), ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+static const Kernels scalarKernels = {addRowScalar, subtractRowScalar, dotScalar};
+#ifdef NNUE_X86
+static const Kernels sse4Kernels = {addRowSse4, subtractRowSse4, dotSse4};
+static const Kernels avx2Kernels = {addRowAvx2, subtractRowAvx2, dotAvx2};
+#endif
+
+static const Kernels* kernels = &scalarKernels;
+static NnueSimd activeSimd = NNUE_SCALAR;
+
+static bool simdSupported(NnueSimd simd) {
+#ifdef NNUE_X86
+    if (simd == NNUE_AVX2) return __builtin_cpu_supports("avx2");
+    if (simd == NNUE_SSE4) return __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("ssse3");
+#endif
+    return simd == NNUE_SCALAR;
+}
+
+bool setNnueSimd(NnueSimd simd) {
+    if (!simdSupported(simd)) return false;
+#ifdef NNUE_X86
+    kernels = simd == NNUE_AVX2 ? &avx2Kernels : simd == NNUE_SSE4 ? &sse4Kernels : &scalarKernels;
+#endif
+    activeSimd = simd;
+    return true;
+}
+
+const char* nnueSimdName() {
+    return activeSimd == NNUE_AVX2 ? "AVX2" : activeSimd == NNUE_SSE4 ? "SSE4.1" : "scalar";
+}
+
+// ---------------------------------------------------------------------------------------------
+// Loading
+
+template <typename T>
+static bool readValues(std::istream& in, T* values, size_t count) {
+    in.read(reinterpret_cast<char*>(values), std::streamsize(count * sizeof(T)));
+    return bool(in);
+}
+
+bool loadNetwork(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cout << "NNUE: cannot open " << path << "\n";
+        return false;
+    }
+
+    // Header: version, hash, description; then the transformer and the hidden layers, each
+    // behind a hash (the hashes only identify the architecture, which the file size checks too)
+    auto net = std::make_unique<Network>();
+    net->transformerBiases.resize(NNUE_HALF_DIMENSIONS);
+    net->transformerWeights.resize(size_t(INPUT_DIMENSIONS) * NNUE_HALF_DIMENSIONS);
+
+    uint32_t version = 0, hash = 0, descriptionLength = 0;
+    bool ok = readValues(in, &version, 1) && readValues(in, &hash, 1) && readValues(in, &descriptionLength, 1) &&
+              version == NNUE_VERSION && descriptionLength <= MAX_DESCRIPTION_LENGTH;
+    std::string description(ok ? descriptionLength : 0, '\0');
+    ok = ok && readValues(in, description.data(), descriptionLength) &&
+         readValues(in, &hash, 1) &&
+         readValues(in, net->transformerBiases.data(), net->transformerBiases.size()) &&
+         readValues(in, net->transformerWeights.data(), net->transformerWeights.size()) &&
+         readValues(in, &hash, 1) &&
+         readValues(in, net->hidden1Biases, HIDDEN_DIMENSIONS) &&
+         readValues(in, net->hidden1Weights, HIDDEN_DIMENSIONS * TRANSFORMED_DIMENSIONS) &&
+         readValues(in, net->hidden2Biases, HIDDEN_DIMENSIONS) &&
+         readValues(in, net->hidden2Weights, HIDDEN_DIMENSIONS * HIDDEN_DIMENSIONS) &&
+         readValues(in, &net->outputBias, 1) &&
+         readValues(in, net->outputWeights, HIDDEN_DIMENSIONS) &&
+         in.peek() == std::ifstream::traits_type::eof();
+    if (!ok) {
+        std::cout << "NNUE: " << path << " is not a HalfKP 256x2-32-32 network\n";
+        return false;
+    }
+
+    network = std::move(net);
+    setNnueSimd(simdSupported(NNUE_AVX2) ? NNUE_AVX2 : simdSupported(NNUE_SSE4) ? NNUE_SSE4 : NNUE_SCALAR);
+    std::cout << "NNUE: loaded " << path << " (" << nnueSimdName() << " kernels)\n";
+    return true;
+}
+
+bool networkLoaded() {
+    return network != nullptr;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Features and accumulators
+
+// Each side sees the board from its own end: Black's view is rotated by 180 degrees
+static inline int orient(int perspective, int sq) {
+    return perspective == WHITE ? sq : sq ^ 63;
+}
+
+// Feature of a non-king piece as seen by one side, relative to that side's king
+static inline int featureIndex(int perspective, int kingSq, int side, int piece, int sq) {
+    int pieceKind = 2 * piece + (side != perspective);
+    return orient(perspective, sq) + pieceKind * 64 + 1 + KING_BUCKET_SIZE * orient(perspective, kingSq);
+}
+
+static inline const int16_t* weightRow(int feature) {
+    return network->transformerWeights.data() + size_t(feature) * NNUE_HALF_DIMENSIONS;
+}
+
+void nnueRefresh(Position& pos, int perspective) {
+    int16_t* accumulator = pos.accumulator.values[perspective];
+    std::memcpy(accumulator, network->transformerBiases.data(), sizeof(pos.accumulator.values[perspective]));
+
+    int kingSq = __builtin_ctzll(pos.pieces[perspective][KING]);
+    for (int side = WHITE; side <= BLACK; ++side) {
+        for (int piece = PAWN; piece < KING; ++piece) {
+            for (uint64_t bb = pos.pieces[side][piece]; bb; bb &= bb - 1) {
+                int feature = featureIndex(perspective, kingSq, side, piece, __builtin_ctzll(bb));
+                kernels->addRow(accumulator, weightRow(feature));
+            }
+        }
+    }
+}
+
+void nnueAddPiece(Position& pos, int side, int piece, int sq) {
+    if (piece == KING) return;
+    for (int perspective = WHITE; perspective <= BLACK; ++perspective) {
+        int kingSq = __builtin_ctzll(pos.pieces[perspective][KING]);
+        kernels->addRow(pos.accumulator.values[perspective], weightRow(featureIndex(perspective, kingSq, side, piece, sq)));
+    }
+}
+
+void nnueRemovePiece(Position& pos, int side, int piece, int sq) {
+    if (piece == KING) return;
+    for (int perspective = WHITE; perspective <= BLACK; ++perspective) {
+        int kingSq = __builtin_ctzll(pos.pieces[perspective][KING]);
+        kernels->subtractRow(pos.accumulator.values[perspective], weightRow(featureIndex(perspective, kingSq, side, piece, sq)));
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// Inference
+
+// One fully connected layer followed by a clipped ReLU
+static void hiddenLayer(const uint8_t* input, int inputSize, const int8_t* weights, const int32_t* biases,
+                        uint8_t* output) {
+    for (int i = 0; i < HIDDEN_DIMENSIONS; ++i) {
+        int32_t sum = biases[i] + kernels->dot(input, weights + i * inputSize, inputSize);
+        output[i] = uint8_t(std::clamp(sum >> WEIGHT_SCALE_BITS, 0, 127));
+    }
+}
+
+int nnueEvaluate(const Position& pos) {
+    int us = pos.whiteToMove ? WHITE : BLACK;
+
+    // The side to move's accumulator comes first
+    alignas(32) uint8_t transformed[TRANSFORMED_DIMENSIONS];
+    for (int half = 0; half < 2; ++half) {
+        const int16_t* accumulator = pos.accumulator.values[half == 0 ? us : us ^ 1];
+        for (int i = 0; i < NNUE_HALF_DIMENSIONS; ++i) {
+            transformed[half * NNUE_HALF_DIMENSIONS + i] = uint8_t(std::clamp<int>(accumulator[i], 0, 127));
+        }
+    }
+
+    alignas(32) uint8_t hidden1[HIDDEN_DIMENSIONS];
+    alignas(32) uint8_t hidden2[HIDDEN_DIMENSIONS];
+    hiddenLayer(transformed, TRANSFORMED_DIMENSIONS, network->hidden1Weights, network->hidden1Biases, hidden1);
+    hiddenLayer(hidden1, HIDDEN_DIMENSIONS, network->hidden2Weights, network->hidden2Biases, hidden2);
+    int32_t output = network->outputBias + kernels->dot(hidden2, network->outputWeights, HIDDEN_DIMENSIONS);
+
+    // Keep clear of mate scores, which the search and its tables treat specially
+    int score = output * 100 / (OUTPUT_SCALE * OUTPUT_PAWN_VALUE);
+    return std::clamp(score, -(MATE_BOUND - 1), MATE_BOUND - 1);
+}
@@ -0,0 +1,56 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstdint>
+#include <string>
+
+// Efficiently updatable neural network evaluation, in the HalfKP 256x2-32-32-1 layout used by
+// Stockfish 12 network files:
+//   input     for each side, one feature per (own king square, non-king piece, square): 64 * 641
+//   transform 41024 -> 256 int16 accumulator per side, kept up to date by makeMove/unmakeMove
+//   hidden    512 (both accumulators clipped to 0..127) -> 32 -> 32, int8 weights, clipped ReLU
+//   output    32 -> 1
+// The dot products run on AVX2 or SSE4.1 when the CPU has them, picked at load time, and on
+// plain C++ otherwise.
+
+const int NNUE_HALF_DIMENSIONS = 256;
+
+const char* const DEFAULT_NNUE_FILE = "nn.nnue";
+
+// Per-side accumulator of the feature transformer, stored in the position
+struct NnueAccumulator {
+    alignas(32) int16_t values[2][NNUE_HALF_DIMENSIONS];  // Indexed [perspective][neuron]
+};
+
+struct Position;
+
+// Kernel sets, fastest last
+enum NnueSimd {
+    NNUE_SCALAR,
+    NNUE_SSE4,
+    NNUE_AVX2
+};
+
+// True while the network evaluates positions; only then do the board functions keep the
+// accumulators up to date, so the classical evaluation pays nothing for it. Positions must be
+// set up after it is switched on.
+extern bool nnueEnabled;
+
+// Read a network file; false (with a message) if it is missing or not a HalfKP 256x2-32-32 net
+bool loadNetwork(const std::string& path);
+bool networkLoaded();
+
+// Force a kernel set for benchmarking; false if the CPU does not support it
+bool setNnueSimd(NnueSimd simd);
+const char* nnueSimdName();
+
+// Score of the position for the side to move, in centipawns
+int nnueEvaluate(const Position& pos);
+
+// Accumulator maintenance, called by the board code while nnueEnabled is set. Kings are not
+// features: when a king moves, its own side's accumulator is rebuilt from scratch instead.
+void nnueAddPiece(Position& pos, int side, int piece, int sq);
+void nnueRemovePiece(Position& pos, int side, int piece, int sq);
+void nnueRefresh(Position& pos, int perspective);
+
+#endif // NNUE_H
@@ -0,0 +1,96 @@
+#include "pawns.h"
+#include "../constants.h"
+
+#include <cstring>
+
+// Per-thread cache of pawn structures, indexed by the low bits of the pawn key
+static thread_local PawnEntry pawnTable[PAWN_TABLE_SIZE];
+static thread_local PawnHashStats stats;
+
+// Pawn structure terms
+const int PASSED_PAWN_BONUS = 50;
+const int ISOLATED_PAWN_PENALTY = 20;  // No own pawn on either adjacent file
+const int DOUBLED_PAWN_PENALTY = 15;   // Another own pawn stands ahead on the same file
+const int BACKWARD_PAWN_PENALTY = 10;  // Its stop square is held by an enemy pawn and no own pawn can ever defend it
+
+// Whole-board fills: every square on the same file above (north) or below (south) a set
+static inline uint64_t northFill(uint64_t b) {
+    b |= b << 8;
+    b |= b << 16;
+    b |= b << 32;
+    return b;
+}
+
+static inline uint64_t southFill(uint64_t b) {
+    b |= b >> 8;
+    b |= b >> 16;
+    b |= b >> 32;
+    return b;
+}
+
+static inline uint64_t eastOne(uint64_t b) { return (b & ~FILE_H) << 1; }
+static inline uint64_t westOne(uint64_t b) { return (b & ~FILE_A) >> 1; }
+
+// Squares ahead of the pawns on their own files, from the given side's point of view
+static inline uint64_t frontSpan(uint64_t pawns, int side) {
+    return side == WHITE ? northFill(pawns << 8) : southFill(pawns >> 8);
+}
+
+// Squares the pawns attack
+static inline uint64_t pawnAttacks(uint64_t pawns, int side) {
+    uint64_t pushed = side == WHITE ? pawns << 8 : pawns >> 8;
+    return eastOne(pushed) | westOne(pushed);
+}
+
+// Work out a structure from scratch. Every term is a set operation on the whole board followed
+// by a popcount, with no per-pawn loop.
+static void analysePawns(const Position& pos, PawnEntry& entry) {
+    uint64_t spans[2];
+    for (int side = WHITE; side <= BLACK; ++side) {
+        spans[side] = frontSpan(pos.pieces[side][PAWN], side);
+        entry.attackSpans[side] = eastOne(spans[side]) | westOne(spans[side]);
+    }
+
+    for (int side = WHITE; side <= BLACK; ++side) {
+        int them = side ^ 1;
+        uint64_t pawns = pos.pieces[side][PAWN];
+
+        entry.passedPawns[side] = pawns & ~(spans[them] | entry.attackSpans[them]);
+
+        uint64_t files = northFill(pawns) | southFill(pawns);
+        uint64_t isolated = pawns & ~(eastOne(files) | westOne(files));
+
+        // A pawn in the rear span of its own side's pawns has one of them in front of it
+        uint64_t doubled = pawns & frontSpan(pawns, them);
+
+        // Counted by stop square; each pawn has exactly one
+        uint64_t stops = side == WHITE ? pawns << 8 : pawns >> 8;
+        uint64_t backwardStops = stops & pawnAttacks(pos.pieces[them][PAWN], them) & ~entry.attackSpans[side];
+
+        entry.score[side] = PASSED_PAWN_BONUS * __builtin_popcountll(entry.passedPawns[side])
+                          - ISOLATED_PAWN_PENALTY * __builtin_popcountll(isolated)
+                          - DOUBLED_PAWN_PENALTY * __builtin_popcountll(doubled)
+                          - BACKWARD_PAWN_PENALTY * __builtin_popcountll(backwardStops);
+    }
+}
+
+const PawnEntry& probePawnTable(const Position& pos) {
+    PawnEntry& entry = pawnTable[pos.pawnKey & (PAWN_TABLE_SIZE - 1)];
+    ++stats.probes;
+    if (entry.key == pos.pawnKey) {
+        ++stats.hits;
+        return entry;
+    }
+
+    entry.key = pos.pawnKey;
+    analysePawns(pos, entry);
+    return entry;
+}
+
+void clearPawnTable() {
+    std::memset(pawnTable, 0, sizeof(pawnTable));
+}
+
+PawnHashStats& pawnHashStats() {
+    return stats;
+}
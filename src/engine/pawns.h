@@ -0,0 +1,32 @@
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include <cstdint>
+
+#include "board.h"
+
+// Everything the evaluation knows about a pawn structure; it depends on the pawns alone, so it is
+// worked out once per structure and cached under the position's pawn key
+struct PawnEntry {
+    uint64_t key;
+    int score[2];              // Pawn structure score of each side
+    uint64_t passedPawns[2];   // Pawns with no enemy pawn ahead on their own or an adjacent file
+    uint64_t attackSpans[2];   // Squares each side's pawns attack now or could attack by advancing
+};
+
+// Each search thread has its own table of this many entries
+const int PAWN_TABLE_SIZE = 8192;
+
+// Pawn table use by the calling thread since its last reset
+struct PawnHashStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+};
+
+// The calling thread's entry for the position's pawn structure, filled in on a miss
+const PawnEntry& probePawnTable(const Position& pos);
+
+void clearPawnTable();
+PawnHashStats& pawnHashStats();
+
+#endif // PAWNS_H
@@ -0,0 +1,121 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+#include <array>
+
+#include "evaluation.h"
+
+// Game phase: how much non-pawn material is left, 24 in the starting position. The evaluation
+// blends the middlegame and endgame scores by it.
+const int PHASE_WEIGHTS[6] = {0, 1, 1, 2, 4, 0};
+const int MAX_PHASE = 24;
+
+// Bonus for a piece on one of the central squares (d4, d5, e4, e5), in both phases
+const int CENTER_CONTROL = 20;
+const uint64_t CENTER_MASK = 0x0000001818000000ULL;
+
+// Piece-square tables from White's side, laid out as seen from White: the first row is rank 8
+const int PAWN_TABLE[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+const int KNIGHT_TABLE[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50
+};
+
+const int BISHOP_TABLE[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20
+};
+
+const int ROOK_TABLE[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0
+};
+
+const int QUEEN_TABLE[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+// The king hides behind its pawns while there is material to attack it, and centralises once
+// it is gone
+const int KING_MIDGAME_TABLE[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20
+};
+
+const int KING_ENDGAME_TABLE[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50
+};
+
+using PsqtTable = std::array<std::array<int, 64>, 12>;
+
+// Material plus square bonus for every piece code on every square, positive for White and
+// negative for Black, so a position's score is the plain sum over its pieces. Kings carry no
+// material: there is always one of each.
+constexpr PsqtTable makePsqt(bool endgame) {
+    const int* tables[6] = {PAWN_TABLE, KNIGHT_TABLE, BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE,
+                            endgame ? KING_ENDGAME_TABLE : KING_MIDGAME_TABLE};
+    PsqtTable table{};
+    for (int type = PAWN; type <= KING; ++type) {
+        int material = type == KING ? 0 : PIECE_VALUES[type];
+        for (int sq = 0; sq < 64; ++sq) {
+            int center = (CENTER_MASK >> sq) & 1 ? CENTER_CONTROL : 0;
+            // The tables are written rank 8 first, so White reads them flipped and Black as is
+            table[makePiece(WHITE, type)][sq] = material + tables[type][sq ^ 56] + center;
+            table[makePiece(BLACK, type)][sq] = -(material + tables[type][sq] + center);
+        }
+    }
+    return table;
+}
+
+inline constexpr PsqtTable PSQT_MIDGAME = makePsqt(false);
+inline constexpr PsqtTable PSQT_ENDGAME = makePsqt(true);
+
+#endif // PSQT_H
@@ -0,0 +1,105 @@
+#include "tt.h"
+
+#include <algorithm>
+#include <cstdint>
+
+TranspositionTable transpositionTable;
+
+const int AGE_MASK = 63;
+
+static inline uint64_t packData(Move move, int score, int depth, int bound, int age) {
+    return uint64_t(move) |
+           (uint64_t(uint16_t(int16_t(score))) << 16) |
+           (uint64_t(std::clamp(depth, 0, 255)) << 32) |
+           (uint64_t(bound) << 40) |
+           (uint64_t(age & AGE_MASK) << 42);
+}
+
+static inline Move dataMove(uint64_t data) { return Move(data & 0xFFFF); }
+static inline int dataScore(uint64_t data) { return int16_t(uint16_t(data >> 16)); }
+static inline int dataDepth(uint64_t data) { return int((data >> 32) & 0xFF); }
+static inline int dataBound(uint64_t data) { return int((data >> 40) & 3); }
+static inline int dataAge(uint64_t data) { return int((data >> 42) & AGE_MASK); }
+
+// Allocate the largest power-of-two number of clusters that fits in the given size
+void TranspositionTable::resize(size_t megabytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(TTCluster) <= std::max<size_t>(megabytes, 1) * 1024 * 1024) count *= 2;
+
+    clusters.reset(new TTCluster[count]);
+    clusterCount = count;
+    indexMask = count - 1;
+    age = 0;
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < clusterCount; ++i) {
+        for (TTEntry& entry : clusters[i].entries) {
+            entry.keyXorData.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    age = 0;
+}
+
+void TranspositionTable::newSearch() {
+    age = (age + 1) & AGE_MASK;
+}
+
+// Look up a position; returns false if it is not in the table
+bool TranspositionTable::probe(uint64_t key, TTData& data) const {
+    if (!clusterCount) return false;
+
+    for (const TTEntry& entry : clusterFor(key).entries) {
+        uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+        if (entryData && (entry.keyXorData.load(std::memory_order_relaxed) ^ entryData) == key) {
+            data = {dataMove(entryData), dataScore(entryData), dataDepth(entryData), dataBound(entryData)};
+            return true;
+        }
+    }
+    return false;
+}
+
+// Save a search result. The same position overwrites its old entry (keeping the old best move if
+// there is no new one); otherwise the shallowest entry from the oldest search is replaced.
+void TranspositionTable::store(uint64_t key, int depth, int score, int bound, Move move) {
+    if (!clusterCount) return;
+
+    TTCluster& cluster = clusterFor(key);
+    TTEntry* replace = &cluster.entries[0];
+    uint64_t replaceData = 0;  // Data of the same position, if it is already stored
+    int replaceWorth = 1 << 30;
+
+    for (TTEntry& entry : cluster.entries) {
+        uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+        bool samePosition = (entry.keyXorData.load(std::memory_order_relaxed) ^ entryData) == key;
+        if (!entryData || samePosition) {
+            replace = &entry;
+            replaceData = samePosition ? entryData : 0;
+            break;
+        }
+
+        // Entries from earlier searches lose 8 plies of worth for every search since
+        int worth = dataDepth(entryData) - 8 * ((age - dataAge(entryData)) & AGE_MASK);
+        if (worth < replaceWorth) {
+            replace = &entry;
+            replaceData = 0;
+            replaceWorth = worth;
+        }
+    }
+
+    if (replaceData) {
+        if (move == NO_MOVE) move = dataMove(replaceData);
+
+        // Keep a deeper result for this position unless the new one is exact or the old one is stale
+        if (bound != BOUND_EXACT && dataAge(replaceData) == age && depth + 2 < dataDepth(replaceData)) {
+            score = dataScore(replaceData);
+            depth = dataDepth(replaceData);
+            bound = dataBound(replaceData);
+        }
+    }
+
+    uint64_t data = packData(move, score, depth, bound, age);
+    replace->keyXorData.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
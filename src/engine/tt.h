@@ -0,0 +1,67 @@
+#ifndef TT_H
+#define TT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "move.h"
+
+// Bound types stored with a score
+const int BOUND_NONE = 0;
+const int BOUND_UPPER = 1;  // Search failed low: the true score is at most this
+const int BOUND_LOWER = 2;  // Search failed high: the true score is at least this
+const int BOUND_EXACT = 3;
+
+const int DEFAULT_HASH_MB = 16;
+
+// One packed 16-byte entry. The data word holds
+//   bits 0-15  best move
+//   bits 16-31 score (signed)
+//   bits 32-39 depth
+//   bits 40-41 bound
+//   bits 42-47 search age
+// and the key is stored XORed with the data. Search threads read and write entries without
+// locks; if two writes interleave, the key check fails and the torn entry is ignored.
+struct TTEntry {
+    std::atomic<uint64_t> keyXorData{0};
+    std::atomic<uint64_t> data{0};
+};
+
+// Unpacked view of an entry returned by a probe
+struct TTData {
+    Move move;
+    int score;
+    int depth;
+    int bound;
+};
+
+const int CLUSTER_SIZE = 4;
+
+// Four entries sharing one cache line, so a probe touches a single line of memory
+struct alignas(64) TTCluster {
+    TTEntry entries[CLUSTER_SIZE];
+};
+
+// Fixed-size transposition table with a power-of-two number of clusters, shared by all search threads
+struct TranspositionTable {
+    std::unique_ptr<TTCluster[]> clusters;
+    size_t clusterCount = 0;
+    uint64_t indexMask = 0;
+    int age = 0;
+
+    void resize(size_t megabytes);
+    void clear();
+    void newSearch();  // Call once per search so old entries can be recognised and replaced
+
+    bool probe(uint64_t key, TTData& data) const;
+    void store(uint64_t key, int depth, int score, int bound, Move move);
+
+    TTCluster& clusterFor(uint64_t key) { return clusters[key & indexMask]; }
+    const TTCluster& clusterFor(uint64_t key) const { return clusters[key & indexMask]; }
+};
+
+extern TranspositionTable transpositionTable;
+
+#endif // TT_H
@@ -20,6 +20,19 @@ std::string squareToNotation(uint64_t square) {
     return std::string(1, file) + std::string(1, rank); // Combine file and rank into a single string
 }
 
+// Convert a packed move to coordinate notation (e.g., "e2e4", "e7e8q")
+std::string moveToNotation(Move move) {
+    if (move == NO_MOVE) {
+        return "null";
+    }
+
+    std::string notation = squareToNotation(1ULL << moveFrom(move)) + squareToNotation(1ULL << moveTo(move));
+    if (moveFlag(move) == MOVE_PROMOTION) {
+        notation += "nbrq"[movePromotion(move) - KNIGHT];
+    }
+    return notation;
+}
+
 // Parse move input like "e2 e4" to bitboard squares
 std::pair<int, int> parseInput(const std::string& input) {
     if (input.size() != 5 || input[2] != ' ') {
@@ -55,35 +68,8 @@ void printBitboard(uint64_t bitboard) {
 }
 
 // Count the number of legal moves for a player
-int countLegalMoves(bool isWhiteTurn) {
-    int moveCount = 0;
-    uint64_t pieces = isWhiteTurn ? whitePieces : blackPieces;
-
-    while (pieces) {
-        uint64_t piece = pieces & -pieces; // Isolate the least significant bit (current piece)
-        pieces &= pieces - 1;              // Remove the isolated piece from the set
-
-        // Generate all legal moves for this piece
-        std::vector<uint64_t> legalMoves;
-        if (isWhiteTurn) {
-            if (whitePawns & piece) legalMoves = generatePawnMoves(piece, true);
-            else if (whiteKnights & piece) legalMoves = generateKnightMoves(piece, true);
-            else if (whiteBishops & piece) legalMoves = generateBishopMoves(piece, true);
-            else if (whiteRooks & piece) legalMoves = generateRookMoves(piece, true);
-            else if (whiteQueens & piece) legalMoves = generateQueenMoves(piece, true);
-            else if (whiteKing & piece) legalMoves = generateKingMoves(piece, true);
-        } else {
-            if (blackPawns & piece) legalMoves = generatePawnMoves(piece, false);
-            else if (blackKnights & piece) legalMoves = generateKnightMoves(piece, false);
-            else if (blackBishops & piece) legalMoves = generateBishopMoves(piece, false);
-            else if (blackRooks & piece) legalMoves = generateRookMoves(piece, false);
-            else if (blackQueens & piece) legalMoves = generateQueenMoves(piece, false);
-            else if (blackKing & piece) legalMoves = generateKingMoves(piece, false);
-        }
-
-        moveCount += legalMoves.size();
-    }
-
-    return moveCount;
+int countLegalMoves(const Position& pos) {
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    return moves.size();
 }
-
@@ -4,10 +4,14 @@
 #include <cstdint>
 #include <string>
 
+#include "board.h"
+#include "move.h"
+
 // Utility functions
 std::string squareToNotation(uint64_t square);
+std::string moveToNotation(Move move);
 std::pair<int, int> parseInput(const std::string& input);
-void printBitBoard(uint64_t bitboard);
-int CountLegalMoves(bool isWhiteTurn);
+void printBitboard(uint64_t bitboard);
+int countLegalMoves(const Position& pos);
 
 #endif
\ No newline at end of file
@@ -7,8 +7,7 @@
 #include "engine/board.h"
 
 // Constants for the GUI
-const int TILE_SIZE = 100;    // Size of each square on the board
-const int BOARD_SIZE = 8;     // Board dimensions (8x8)
+const int TILE_SIZE = 100;    // Size of each square on the board (BOARD_SIZE comes from constants.h)
 
 // Global variables for the GUI
 extern sf::Vector2i selectedSquare; // Currently selected square for dragging
@@ -1,16 +1,54 @@
 #include "engine/board.h"
+#include "engine/attacks.h"
 #include "engine/gameloops.h"
 #include "engine/ai.h"
+#include "engine/tt.h"
+#include "engine/evaluation.h"
+#include "engine/nnue.h"
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
 
 
 using namespace std;
 
 // Main function to choose game mode
-int main() {
+int main(int argc, char* argv[]) {
+    // Options: --hash <MB> sets the transposition table size, --threads <N> the number of search threads,
+    // --ponder lets the computer think on the human's time, --eval auto|classical|nnue picks the
+    // evaluation (auto uses the network if its file is there), --nnue <file> names the network and
+    // --nnue-simd scalar|sse4|avx2 overrides the detected kernels
+    size_t hashMegabytes = DEFAULT_HASH_MB;
+    bool ponder = false;
+    std::string eval = "auto";
+    std::string networkFile = DEFAULT_NNUE_FILE;
+    std::string simd;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hash" && i + 1 < argc) hashMegabytes = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) searchThreads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--ponder") ponder = true;
+        else if (arg == "--eval" && i + 1 < argc) eval = argv[++i];
+        else if (arg == "--nnue" && i + 1 < argc) networkFile = argv[++i];
+        else if (arg == "--nnue-simd" && i + 1 < argc) simd = argv[++i];
+    }
+
+    initializeAttackTables();
     initializeZobrist();
-    initializePosition();
-    printBitboard(whitePawns);
+    transpositionTable.resize(hashMegabytes);
+
+    // The network has to be in place before any position is set up
+    bool wantNetwork = eval == "nnue" || (eval == "auto" && std::filesystem::exists(networkFile));
+    if (wantNetwork && loadNetwork(networkFile)) {
+        if (!simd.empty() && !setNnueSimd(simd == "avx2" ? NNUE_AVX2 : simd == "sse4" ? NNUE_SSE4 : NNUE_SCALAR)) {
+            cout << "NNUE: " << simd << " is not supported on this CPU, using " << nnueSimdName() << "\n";
+        }
+        setEvalBackend(EVAL_NNUE);
+    } else if (wantNetwork) {
+        cout << "Using the classical evaluation\n";
+    }
     cout << "Welcome to Chess!\nChoose game mode:\n1. Human vs Human\n2. Human vs Computer\n";
     int choice;
     cin >> choice;
@@ -24,7 +62,7 @@ int main() {
         cin >> colorChoice;
         cin.ignore();
         bool humanPlaysWhite = (colorChoice == 'y' || colorChoice == 'Y');
-        computerGameLoop(humanPlaysWhite);
+        computerGameLoop(humanPlaysWhite, ponder);
     } else {
         cout << "Invalid choice. Exiting program.\n";
     }
@@ -0,0 +1,153 @@
+#include "engine/board.h"
+#include "engine/attacks.h"
+#include "engine/utils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Standard perft reference positions with known node counts
+struct PerftCase {
+    const char* name;
+    const char* fen;
+    int depth;
+    uint64_t nodes;
+};
+
+static const PerftCase referencePositions[] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292},
+    {"position4-mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 5, 15833292},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594},
+};
+
+// Count leaf nodes; with bulk counting the last ply returns the move count without making the moves
+static uint64_t perft(Position& pos, int depth, bool bulk) {
+    if (depth == 0) return 1;
+
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    if (bulk && depth == 1) return moves.size();
+
+    uint64_t nodes = 0;
+    for (Move move : moves) {
+        UndoInfo undo = makeMove(pos, move);
+        nodes += perft(pos, depth - 1, bulk);
+        unmakeMove(pos, move, undo);
+    }
+    return nodes;
+}
+
+// Run perft, splitting the root moves across threads, and return the total node count
+static uint64_t divide(const Position& root, int depth, bool bulk, int threads, bool printDivide) {
+    if (depth <= 0) return 1;
+
+    MoveList moves;
+    generateLegalMoves(root, moves);
+
+    std::vector<uint64_t> counts(moves.size(), 0);
+    std::atomic<int> next(0);
+
+    auto worker = [&]() {
+        Position local = root; // Each thread works on its own copy
+        for (int i = next++; i < moves.size(); i = next++) {
+            UndoInfo undo = makeMove(local, moves[i]);
+            counts[i] = perft(local, depth - 1, bulk);
+            unmakeMove(local, moves[i], undo);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+
+    uint64_t total = 0;
+    for (int i = 0; i < moves.size(); ++i) {
+        if (printDivide) std::cout << moveToNotation(moves[i]) << ": " << counts[i] << "\n";
+        total += counts[i];
+    }
+    return total;
+}
+
+// Time one perft run and print the node count and speed
+static uint64_t runPerft(const Position& pos, int depth, bool bulk, int threads, bool printDivide) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = divide(pos, depth, bulk, threads, printDivide);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Nodes: " << nodes << "  Time: " << int(seconds * 1000) << " ms"
+         << "  NPS: " << uint64_t(nodes / std::max(seconds, 1e-9)) << "\n";
+    return nodes;
+}
+
+static void printUsage() {
+    std::cout << "Usage:\n"
+         << "  chess_perft [options] <depth> [fen]   divide and total for a position (default: start position)\n"
+         << "  chess_perft [options] --suite         run the standard reference positions and check the counts\n"
+         << "Options:\n"
+         << "  --bulk         count the last ply from the move list size instead of making the moves\n"
+         << "  --threads N    split the root moves across N threads\n";
+}
+
+int main(int argc, char* argv[]) {
+    initializeAttackTables();
+    initializeZobrist();
+
+    bool bulk = false, suite = false;
+    int threads = 1, depth = -1;
+    std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bulk") bulk = true;
+        else if (arg == "--suite") suite = true;
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(1, std::atoi(argv[++i]));
+        else if (depth < 0 && !arg.empty() && std::isdigit(arg[0])) depth = std::atoi(arg.c_str());
+        else if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+        else {
+            // The rest of the command line is the FEN (it contains spaces)
+            fen = arg;
+            while (i + 1 < argc) fen += std::string(" ") + argv[++i];
+        }
+    }
+
+    if (suite) {
+        int failures = 0;
+        for (const PerftCase& test : referencePositions) {
+            Position pos;
+            setPositionFromFen(pos, test.fen);
+            std::cout << test.name << " depth " << test.depth << ": ";
+            uint64_t nodes = runPerft(pos, test.depth, bulk, threads, false);
+            if (nodes != test.nodes) {
+                std::cout << "  FAILED: expected " << test.nodes << "\n";
+                ++failures;
+            }
+        }
+        std::cout << (failures ? "Reference positions FAILED\n" : "All reference positions passed\n");
+        return failures ? 1 : 0;
+    }
+
+    if (depth < 0) {
+        printUsage();
+        return 1;
+    }
+
+    Position pos;
+    if (!setPositionFromFen(pos, fen)) {
+        std::cout << "Invalid FEN: " << fen << "\n";
+        return 1;
+    }
+    runPerft(pos, depth, bulk, threads, true);
+    return 0;
+}